@@ -3,8 +3,13 @@
 #include <stdio.h>
 #include "assert.h"
 #include "compress40.h"
+#include "stats.h"
+#include "codec40.h"
+#include "segment.h"
 
 static void (*compress_or_decompress)(FILE *input) = compress40;
+static int print_stats = 0;
+static const char *trace_path = NULL;
 
 int main(int argc, char *argv[])
 {
@@ -15,20 +20,67 @@ int main(int argc, char *argv[])
                         compress_or_decompress = compress40;
                 } else if (strcmp(argv[i], "-d") == 0) {
                         compress_or_decompress = decompress40;
+                } else if (strcmp(argv[i], "-a") == 0) {
+                        compress_or_decompress = analyze40;
+                } else if (strcmp(argv[i], "--variance-map") == 0 &&
+                           i + 1 < argc) {
+                        analyze40_variance_map(argv[++i]);
+                } else if (strcmp(argv[i], "-u") == 0 && i + 2 < argc) {
+                        compress_or_decompress = recompress40;
+                        recompress40_files(argv[i + 1], argv[i + 2]);
+                        i += 2;
+                } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+                        const Layout *layout = Layout_by_name(argv[++i]);
+                        if (layout == NULL) {
+                                fprintf(stderr, "%s: unknown layout '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                        compress40_layout(layout);
+                } else if (strcmp(argv[i], "-s") == 0) {
+                        compress40_segmented(DEFAULT_SEGMENT_ROWS);
+                } else if (strcmp(argv[i], "--i420") == 0) {
+                        decompress40_i420();
+                } else if (strcmp(argv[i], "--i420-size") == 0 &&
+                           i + 1 < argc) {
+                        int width, height;
+                        if (sscanf(argv[++i], "%dx%d", &width,
+                                   &height) != 2 || width < 1 || height < 1) {
+                                fprintf(stderr, "%s: bad size '%s'\n",
+                                        argv[0], argv[i]);
+                                exit(1);
+                        }
+                        compress40_i420(width, height);
+                } else if (strcmp(argv[i], "--stats") == 0) {
+                        print_stats = 1;
+                } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                        print_stats = 1;
+                        trace_path = argv[++i];
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n",
                                 argv[0], argv[i]);
                         exit(1);
                 } else if (argc - i > 2) {
-                        fprintf(stderr, "Usage: %s -d [filename]\n"
-                                "       %s -c [filename]\n",
-                                argv[0], argv[0]);
+                        fprintf(stderr, "Usage: %s -d [--i420] [--stats] "
+                                "[--trace tracefile] [filename]\n"
+                                "       %s -c [-l layout] [-s] "
+                                "[--i420-size WxH] [--stats] "
+                                "[--trace tracefile] [filename]\n"
+                                "       %s -u oldimage compressed "
+                                "[--stats] [filename]\n"
+                                "       %s -a [--variance-map pgmfile] "
+                                "[--stats] [filename]\n",
+                                argv[0], argv[0], argv[0], argv[0]);
                         exit(1);
                 } else {
                         break;
                 }
         }
         assert(argc - i <= 1);    /* at most one file on command line */
+        if (print_stats && !STATS_ENABLED) {
+                fprintf(stderr, "%s: built without statistics, "
+                        "rebuild with make STATS=1\n", argv[0]);
+        }
         if (i < argc) {
                 FILE *fp = fopen(argv[i], "r");
                 assert(fp != NULL);
@@ -37,6 +89,9 @@ int main(int argc, char *argv[])
         } else {
                 compress_or_decompress(stdin);
         }
+        if (print_stats) {
+                STATS_REPORT(stderr, trace_path);
+        }
 
         return EXIT_SUCCESS; 
 }
@@ -0,0 +1,344 @@
+/* analyze.c
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains compressed-domain analysis. The a, pb and pr fields
+ * of the codewords already form a half-resolution image, and b, c and d
+ * give each block's variance, so mean color, histograms, a perceptual
+ * hash and a variance map all come from the quantized fields without
+ * unpackPixels or a full-resolution color conversion.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include <reader.h>
+#include <transforms.h>
+#include <quan.h>
+#include <analyze.h>
+#include <stats.h>
+#include <codec40.h>
+
+#define NUM_FIELDS 6
+
+static const char *variance_map_path = NULL;
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static void fill_grid(Analysis *analysis, const float *dc);
+static unsigned char to_byte(float value);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      analyze40_variance_map
+ * purpose:   Makes analyze40 also write the block variance map as a PGM.
+ * arguments: const char *path - path of the PGM file to write
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void analyze40_variance_map(const char *path) {
+        variance_map_path = path;
+}
+
+/*
+ * name:      analyze40
+ * purpose:   Reads a compressed image and prints its compressed-domain
+ *            statistics to stdout as JSON.
+ * arguments: FILE *input - the input file pointer to the compressed image.
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void analyze40(FILE *input) {
+        size_t size = 0;
+        int width, height;
+        const Layout *layout;
+
+        STATS_BEGIN(STATS_READ);
+        uint64_t *codewords = read_compressed(input, &size, &width, &height,
+                                              &layout);
+        STATS_END(STATS_READ);
+
+        STATS_BEGIN(STATS_QUANTIZE);
+        Analysis *analysis = analyze_codewords(codewords, width, height,
+                                               layout);
+        STATS_END(STATS_QUANTIZE);
+
+        STATS_BEGIN(STATS_WRITE);
+        print_analysis(stdout, analysis);
+        if (variance_map_path != NULL) {
+                FILE *fp = fopen(variance_map_path, "wb");
+                assert(fp != NULL);
+                print_variance_map(fp, analysis);
+                fclose(fp);
+        }
+        STATS_END(STATS_WRITE);
+
+        free_analysis(analysis);
+        free(codewords);
+}
+
+/*
+ * name:      analyze_codewords
+ * purpose:   Computes image statistics from codewords alone. All six
+ *            fields are extracted with one bulk Bitpack call. A branch-
+ *            free pass over the a, b, c and d arrays, which the compiler
+ *            vectorizes, gives the DC luma and block variances; a second,
+ *            scalar pass does the chroma table lookups and histograms.
+ * arguments: const uint64_t *codewords - one codeword per 2x2 block
+ *            int width, int height - dimensions of the image
+ *            const Layout *layout - codeword layout of the data
+ * returns:   Analysis* - the statistics, freed with free_analysis
+ * Author: Alijah Jackson
+ */
+Analysis *analyze_codewords(const uint64_t *codewords, int width,
+                            int height, const Layout *layout) {
+        Analysis *analysis = calloc(1, sizeof(Analysis));
+        assert(analysis != NULL);
+        analysis->block_width = width / 2;
+        analysis->block_height = height / 2;
+        size_t n = (size_t)analysis->block_width * analysis->block_height;
+
+        int32_t *quantized = malloc(NUM_FIELDS * n * sizeof(int32_t) + 1);
+        int32_t *values[NUM_FIELDS];
+        for (int f = 0; f < NUM_FIELDS; f++) {
+                values[f] = quantized + f * n;
+        }
+        Bitpack_field fields[NUM_FIELDS];
+        layoutFields(layout, fields);
+        Bitpack_unpackv(codewords, n, fields, NUM_FIELDS, values);
+
+        float *chroma_table = malloc((1u << layout->chroma_width) *
+                                     sizeof(float));
+        float bcd_scale = dequantizeTables(layout, NULL, chroma_table);
+
+        float *dc = malloc(3 * n * sizeof(float) + 1);
+        float *dc_y = malloc(n * sizeof(float) + 1);
+        analysis->variance_map = malloc(n * sizeof(float) + 1);
+        assert(quantized != NULL && chroma_table != NULL && dc != NULL &&
+               dc_y != NULL &&
+               analysis->variance_map != NULL);
+
+        /*
+         * Pixels are a +/- b +/- c +/- d, so a block's variance is
+         * b^2 + c^2 + d^2. Summing it as an integer "energy" of the
+         * quantized fields keeps this pass free of branches, lookups and
+         * float reductions, so the compiler vectorizes it.
+         */
+        const int32_t *a = values[0], *qb = values[1], *qc = values[2],
+                      *qd = values[3];
+        float a_max = (float)((1u << layout->a_width) - 1);
+        float variance_scale = bcd_scale * bcd_scale;
+        int64_t sum_a = 0, sum_energy = 0;
+        int32_t max_energy = 0;
+        for (size_t i = 0; i < n; i++) {
+                int32_t energy = qb[i] * qb[i] + qc[i] * qc[i] +
+                                 qd[i] * qd[i];
+                dc_y[i] = a[i] / a_max;
+                analysis->variance_map[i] = energy * variance_scale;
+                sum_a += a[i];
+                sum_energy += energy;
+                max_energy = energy > max_energy ? energy : max_energy;
+        }
+
+        /* Chroma table lookups and histograms stay scalar */
+        double sum_pb = 0, sum_pr = 0;
+        for (size_t i = 0; i < n; i++) {
+                dc[3 * i] = dc_y[i];
+                dc[3 * i + 1] = chroma_table[values[4][i]];
+                dc[3 * i + 2] = chroma_table[values[5][i]];
+                analysis->hist_y[to_byte(dc_y[i])]++;
+                sum_pb += dc[3 * i + 1];
+                sum_pr += dc[3 * i + 2];
+        }
+
+        if (n > 0) {
+                analysis->mean_y = sum_a / (double)a_max / n;
+                analysis->mean_pb = sum_pb / n;
+                analysis->mean_pr = sum_pr / n;
+                analysis->mean_variance = sum_energy *
+                                          (double)variance_scale / n;
+        }
+        analysis->max_variance = max_energy * variance_scale;
+
+        float mean[3] = { analysis->mean_y, analysis->mean_pb,
+                          analysis->mean_pr };
+        unsigned char *mean_rgb = ypbpr_to_rgb(mean, 1, 1, 255);
+        memcpy(analysis->mean_rgb, mean_rgb, 3);
+        free(mean_rgb);
+
+        unsigned char *rgb = ypbpr_to_rgb(dc, analysis->block_width,
+                                          analysis->block_height, 255);
+        for (size_t i = 0; i < n; i++) {
+                analysis->hist_rgb[0][rgb[3 * i]]++;
+                analysis->hist_rgb[1][rgb[3 * i + 1]]++;
+                analysis->hist_rgb[2][rgb[3 * i + 2]]++;
+        }
+
+        fill_grid(analysis, dc);
+
+        free(rgb);
+        free(dc_y);
+        free(dc);
+        free(chroma_table);
+        free(quantized);
+        return analysis;
+}
+
+/*
+ * name:      print_analysis
+ * purpose:   Prints an analysis as a JSON object.
+ * arguments: FILE *fp - stream to print to
+ *            const Analysis *analysis - the statistics
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void print_analysis(FILE *fp, const Analysis *analysis) {
+        static const char *CHANNELS[3] = { "r", "g", "b" };
+
+        fprintf(fp, "{\n  \"width\": %d,\n  \"height\": %d,\n",
+                analysis->block_width * 2, analysis->block_height * 2);
+        fprintf(fp, "  \"mean\": { \"y\": %.6f, \"pb\": %.6f, "
+                "\"pr\": %.6f, \"rgb\": [%u, %u, %u] },\n",
+                analysis->mean_y, analysis->mean_pb, analysis->mean_pr,
+                analysis->mean_rgb[0], analysis->mean_rgb[1],
+                analysis->mean_rgb[2]);
+        fprintf(fp, "  \"phash\": \"%016llx\",\n",
+                (unsigned long long)analysis->phash);
+
+        fprintf(fp, "  \"variance\": { \"mean\": %.6g, \"max\": %.6g, "
+                "\"grid\": [", analysis->mean_variance,
+                analysis->max_variance);
+        for (int i = 0; i < ANALYSIS_GRID * ANALYSIS_GRID; i++) {
+                fprintf(fp, "%s%.6g", i == 0 ? "" : ", ",
+                        analysis->variance_grid[i]);
+        }
+        fprintf(fp, "] },\n  \"histograms\": {\n    \"y\": [");
+        for (int bin = 0; bin < ANALYSIS_BINS; bin++) {
+                fprintf(fp, "%s%llu", bin == 0 ? "" : ",",
+                        (unsigned long long)analysis->hist_y[bin]);
+        }
+        fprintf(fp, "]");
+        for (int channel = 0; channel < 3; channel++) {
+                fprintf(fp, ",\n    \"%s\": [", CHANNELS[channel]);
+                for (int bin = 0; bin < ANALYSIS_BINS; bin++) {
+                        fprintf(fp, "%s%llu", bin == 0 ? "" : ",",
+                                (unsigned long long)
+                                analysis->hist_rgb[channel][bin]);
+                }
+                fprintf(fp, "]");
+        }
+        fprintf(fp, "\n  }\n}\n");
+}
+
+/*
+ * name:      print_variance_map
+ * purpose:   Prints the block variance map as a binary PGM, one pixel
+ *            per block, scaled by standard deviation so the largest
+ *            variance is white.
+ * arguments: FILE *fp - stream to print to
+ *            const Analysis *analysis - the statistics
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void print_variance_map(FILE *fp, const Analysis *analysis) {
+        size_t n = (size_t)analysis->block_width * analysis->block_height;
+        float max_deviation = sqrtf(analysis->max_variance);
+
+        fprintf(fp, "P5\n%d %d\n255\n", analysis->block_width,
+                analysis->block_height);
+        for (size_t i = 0; i < n; i++) {
+                float deviation = sqrtf(analysis->variance_map[i]);
+                fputc(max_deviation > 0 ? to_byte(deviation / max_deviation)
+                                        : 0, fp);
+        }
+}
+
+/*
+ * name:      free_analysis
+ * purpose:   Frees an analysis and its variance map.
+ * arguments: Analysis *analysis - the analysis to free
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void free_analysis(Analysis *analysis) {
+        free(analysis->variance_map);
+        free(analysis);
+}
+
+/*
+************************  HELPER FUNCTIONS ****************************
+*/
+
+/*
+ * name:      fill_grid
+ * purpose:   Averages the block DC values and variances over an 8x8 grid.
+ *            The grid of DC averages gives the perceptual hash: each bit
+ *            is set where a cell is brighter than the mean of all cells.
+ * arguments: Analysis *analysis - analysis with its variance map filled
+ *            const float *dc - per-block YPbPr values
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void fill_grid(Analysis *analysis, const float *dc) {
+        int block_width = analysis->block_width;
+        int block_height = analysis->block_height;
+        float cell_y[ANALYSIS_GRID * ANALYSIS_GRID];
+        float total = 0;
+
+        if (block_width == 0 || block_height == 0) return;
+
+        for (int gy = 0; gy < ANALYSIS_GRID; gy++) {
+                int y0 = gy * block_height / ANALYSIS_GRID;
+                int y1 = (gy + 1) * block_height / ANALYSIS_GRID;
+                y1 = (y1 > y0) ? y1 : y0 + 1;
+                for (int gx = 0; gx < ANALYSIS_GRID; gx++) {
+                        int x0 = gx * block_width / ANALYSIS_GRID;
+                        int x1 = (gx + 1) * block_width / ANALYSIS_GRID;
+                        x1 = (x1 > x0) ? x1 : x0 + 1;
+
+                        float sum_y = 0, sum_variance = 0;
+                        for (int row = y0; row < y1; row++) {
+                                for (int col = x0; col < x1; col++) {
+                                        size_t i = (size_t)row * block_width
+                                                   + col;
+                                        sum_y += dc[3 * i];
+                                        sum_variance +=
+                                                analysis->variance_map[i];
+                                }
+                        }
+                        int cells = (y1 - y0) * (x1 - x0);
+                        int cell = gy * ANALYSIS_GRID + gx;
+                        cell_y[cell] = sum_y / cells;
+                        analysis->variance_grid[cell] = sum_variance / cells;
+                        total += cell_y[cell];
+                }
+        }
+
+        float mean = total / (ANALYSIS_GRID * ANALYSIS_GRID);
+        analysis->phash = 0;
+        for (int cell = 0; cell < ANALYSIS_GRID * ANALYSIS_GRID; cell++) {
+                if (cell_y[cell] > mean) {
+                        analysis->phash |= 1ULL << cell;
+                }
+        }
+}
+
+/*
+ * name:      to_byte
+ * purpose:   Maps a value in [0, 1] to a byte, clamping outside values
+ * arguments: float value - the value to map
+ * returns:   unsigned char - the byte
+ * Author: Alijah Jackson
+ */
+static unsigned char to_byte(float value) {
+        return (unsigned char)roundf(clamp(value, 0, 1) * 255.0f);
+}
@@ -0,0 +1,39 @@
+/* analyze.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains declarations for compressed-domain analysis: image
+ * statistics computed straight from the quantized codeword fields,
+ * without decoding to pixels.
+ */
+
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <layout.h>
+
+#define ANALYSIS_BINS 256
+#define ANALYSIS_GRID 8
+
+typedef struct Analysis {
+        int block_width, block_height;
+        float mean_y, mean_pb, mean_pr;
+        unsigned char mean_rgb[3];
+        uint64_t hist_y[ANALYSIS_BINS];
+        uint64_t hist_rgb[3][ANALYSIS_BINS];
+        uint64_t phash;
+        float mean_variance, max_variance;
+        float variance_grid[ANALYSIS_GRID * ANALYSIS_GRID];
+        float *variance_map;    /* one value per block, row-major */
+} Analysis;
+
+Analysis *analyze_codewords(const uint64_t *codewords, int width,
+                            int height, const Layout *layout);
+void print_analysis(FILE *fp, const Analysis *analysis);
+void print_variance_map(FILE *fp, const Analysis *analysis);
+void free_analysis(Analysis *analysis);
+
+#endif
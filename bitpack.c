@@ -6,6 +6,7 @@
  */
 
 #include "bitpack.h"
+#include "bitpackv.h"
 #include <assert.h>
 #include <stdio.h>
 
@@ -125,4 +126,105 @@ uint64_t Bitpack_news(uint64_t word, unsigned width, unsigned lsb,
         uint64_t mask = ((1ULL << width) - 1) << lsb;
         uint64_t uvalue = (uint64_t)value & ((1ULL << width) - 1);
         return (word & ~mask) | ((uvalue << lsb) & mask);
-}
\ No newline at end of file
+}
+
+/*
+******************************  BULK FUNCTIONS ************************
+*/
+
+/*
+ * The bulk functions work one field at a time over the whole batch, so
+ * each inner loop is a single shift-and-mask with loop-invariant width
+ * and lsb that the compiler can vectorize. Fields are contiguous, which
+ * makes shift-and-mask exactly what PEXT/PDEP would compute. The loops
+ * themselves are inline in bitpackv.h so the codec kernels get them with
+ * constant widths; the functions here serve callers with a runtime
+ * field table. Range checks run once per field per batch and are left
+ * out entirely when built with BITPACK_UNCHECKED (make RELEASE=1).
+ */
+
+/*
+ * name:      Bitpack_fitsv
+ * purpose:   Check if every value in an array fits a field
+ * arguments: Bitpack_field field - the field to fit within
+ *            const int32_t *values - the values to check
+ *            size_t n - number of values
+ * returns:   bool - true if all values fit, false otherwise
+ * Author: Alijah Jackson
+ */
+bool Bitpack_fitsv(Bitpack_field field, const int32_t *values, size_t n) {
+        if (n == 0) return true;
+        int32_t min = values[0];
+        int32_t max = values[0];
+        for (size_t i = 1; i < n; i++) {
+                min = values[i] < min ? values[i] : min;
+                max = values[i] > max ? values[i] : max;
+        }
+        if (field.is_signed) {
+                return Bitpack_fitss(min, field.width) &&
+                       Bitpack_fitss(max, field.width);
+        }
+        return min >= 0 && Bitpack_fitsu((uint64_t)max, field.width);
+}
+
+#ifndef BITPACK_UNCHECKED
+/*
+ * name:      Bitpack_checkv
+ * purpose:   Raise Bitpack_Overflow unless every value fits a field
+ * arguments: Bitpack_field field - the field to fit within
+ *            const int32_t *values - the values to check
+ *            size_t n - number of values
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Bitpack_checkv(Bitpack_field field, const int32_t *values, size_t n) {
+        if (!Bitpack_fitsv(field, values, n)) {
+                RAISE(Bitpack_Overflow);
+        }
+}
+#endif
+
+/*
+ * name:      Bitpack_packv
+ * purpose:   Pack n words from one value array per field
+ * arguments: uint64_t *words - the n words to write
+ *            size_t n - number of words
+ *            const Bitpack_field *fields - width and lsb of each field
+ *            unsigned num_fields - number of fields
+ *            int32_t *const *values - one array of n values per field
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Bitpack_packv(uint64_t *words, size_t n, const Bitpack_field *fields,
+                   unsigned num_fields, int32_t *const *values) {
+        for (size_t i = 0; i < n; i++) {
+                words[i] = 0;
+        }
+        for (unsigned f = 0; f < num_fields; f++) {
+                assert(fields[f].width >= 1 && fields[f].width <= 32 &&
+                       fields[f].width + fields[f].lsb <= 64);
+                Bitpack_checkv(fields[f], values[f], n);
+                Bitpack_packv_field(words, n, fields[f], values[f]);
+        }
+}
+
+/*
+ * name:      Bitpack_unpackv
+ * purpose:   Unpack n words into one value array per field
+ * arguments: const uint64_t *words - the n words to read
+ *            size_t n - number of words
+ *            const Bitpack_field *fields - width and lsb of each field
+ *            unsigned num_fields - number of fields
+ *            int32_t **values - one array of n values per field to fill
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Bitpack_unpackv(const uint64_t *words, size_t n,
+                     const Bitpack_field *fields, unsigned num_fields,
+                     int32_t **values) {
+        for (unsigned f = 0; f < num_fields; f++) {
+                assert(fields[f].width >= 1 && fields[f].width <= 32 &&
+                       fields[f].width + fields[f].lsb <= 64);
+                Bitpack_unpackv_field(words, n, fields[f], values[f]);
+        }
+}
@@ -0,0 +1,90 @@
+/* bitpackv.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the bulk Bitpack interface, which packs and unpacks
+ * whole arrays of codewords to and from one value array per field. The
+ * per-field loops are static inline here, so a caller that passes a
+ * literal width and lsb gets them folded into the shift and mask.
+ */
+
+#ifndef BITPACKV_H
+#define BITPACKV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct Bitpack_field {
+        unsigned width;
+        unsigned lsb;
+        bool is_signed;
+} Bitpack_field;
+
+bool Bitpack_fitsv(Bitpack_field field, const int32_t *values, size_t n);
+
+/* Raises Bitpack_Overflow unless every value fits; free when unchecked */
+#ifdef BITPACK_UNCHECKED
+#define Bitpack_checkv(field, values, n) ((void)0)
+#else
+void Bitpack_checkv(Bitpack_field field, const int32_t *values, size_t n);
+#endif
+
+void Bitpack_packv(uint64_t *words, size_t n, const Bitpack_field *fields,
+                   unsigned num_fields, int32_t *const *values);
+void Bitpack_unpackv(const uint64_t *words, size_t n,
+                     const Bitpack_field *fields, unsigned num_fields,
+                     int32_t **values);
+
+/*
+ * name:      Bitpack_packv_field
+ * purpose:   ORs one field of n words in from an array of values, which
+ *            must already fit the field (see Bitpack_checkv)
+ * arguments: uint64_t *words - the n words to update
+ *            size_t n - number of words
+ *            Bitpack_field field - width and lsb of the field
+ *            const int32_t *values - the n values
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static inline void Bitpack_packv_field(uint64_t *words, size_t n,
+                                       Bitpack_field field,
+                                       const int32_t *values) {
+        uint64_t mask = (1ULL << field.width) - 1;
+        for (size_t i = 0; i < n; i++) {
+                words[i] |= ((uint64_t)(int64_t)values[i] & mask)
+                            << field.lsb;
+        }
+}
+
+/*
+ * name:      Bitpack_unpackv_field
+ * purpose:   Extracts one field of n words into an array of values.
+ *            Signed fields are sign-extended with a shift pair.
+ * arguments: const uint64_t *words - the n words to read
+ *            size_t n - number of words
+ *            Bitpack_field field - width, lsb and signedness of the field
+ *            int32_t *values - the n values to fill
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static inline void Bitpack_unpackv_field(const uint64_t *words, size_t n,
+                                         Bitpack_field field,
+                                         int32_t *values) {
+        if (field.is_signed) {
+                unsigned up = 64 - field.lsb - field.width;
+                unsigned down = 64 - field.width;
+                for (size_t i = 0; i < n; i++) {
+                        values[i] = (int32_t)((int64_t)(words[i] << up)
+                                              >> down);
+                }
+        } else {
+                uint64_t mask = (1ULL << field.width) - 1;
+                for (size_t i = 0; i < n; i++) {
+                        values[i] = (int32_t)((words[i] >> field.lsb)
+                                              & mask);
+                }
+        }
+}
+
+#endif
@@ -0,0 +1,1223 @@
+/* check40.c
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the differential and performance check run by
+ * "make check". Randomized images of many sizes, odd ones included, go
+ * through every encode/decode path; each path is compared against a
+ * scalar reference built on the single-field Bitpack functions, byte for
+ * byte where the path should be exact and by PSNR where it is lossy.
+ * Encode and decode throughput on a fixed synthetic corpus is then
+ * compared with a recorded baseline.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <arith40.h>
+#include <bitpack.h>
+#include <reader.h>
+#include <transforms.h>
+#include <quan.h>
+#include <planar.h>
+#include <analyze.h>
+#include <segment.h>
+
+#define BCD_RANGE 0.3f
+#define PERF_WIDTH 1024
+#define PERF_HEIGHT 768
+#define PERF_IMAGES 3
+#define PERF_REPEATS 5
+
+typedef struct Image {
+        int width, height;
+        unsigned char *rgb;
+} Image;
+
+static const int SIZES[][2] = {
+        { 2, 2 }, { 3, 3 }, { 4, 2 }, { 9, 8 }, { 8, 9 }, { 17, 33 },
+        { 31, 2 }, { 64, 64 }, { 127, 255 }, { 256, 130 }, { 333, 97 }
+};
+#define NUM_SIZES (int)(sizeof(SIZES) / sizeof(SIZES[0]))
+
+/*
+ * PSNR floors for the RGB round trip of the whole corpus, per layout, at
+ * 8 bits per channel. Single small images with hard edges inside a 2x2
+ * block can legitimately fall well below these.
+ */
+static const double PSNR_FLOOR[NUM_LAYOUTS] = { 24.0, 28.0 };
+static double total_error[NUM_LAYOUTS];
+static size_t total_bytes[NUM_LAYOUTS];
+
+static uint64_t rng_state = 0x40C0DEC40C0DEC40ULL;
+static int failures = 0;
+static int checks = 0;
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static uint64_t next_random(void);
+static Image random_image(int width, int height);
+static Image trimmed(Image image);
+static void check(int ok, const char *name, const Image *image,
+                  const char *detail);
+static uint64_t *reference_pack(const float *ypbpr, int width, int height,
+                                const Layout *layout);
+static float *reference_unpack(const uint64_t *codewords, int width,
+                               int height, const Layout *layout);
+static Planar reference_planes(const Image *image);
+static uint64_t *reference_pack_planar(const Planar *planes,
+                                       const Layout *layout);
+static unsigned reference_chroma_index(float value, unsigned width);
+static float reference_chroma(unsigned index, unsigned width);
+static double squared_error(const unsigned char *a, const unsigned char *b,
+                            size_t n);
+static double psnr(double error, size_t n);
+static void check_kernels(const Image *image);
+static void check_bulk_bitpack(void);
+static void check_crc32c(void);
+static void check_cli(const Image *image, const char *program,
+                      const char *dir);
+static void write_i420(const Image *image, const char *path);
+static Planar trimmed_i420(const Image *image);
+static void write_expected(const Planar *planes, const Layout *layout,
+                           const char *dir);
+static int corrupt_segment(const char *path, int segment);
+static int run_perf(const char *baseline, const char *record,
+                    const char *flavour, double tolerance);
+static int read_baseline(const char *path, const char *flavour,
+                         double expected[2]);
+static void record_baseline(const char *path, const char *flavour,
+                            const double best[2]);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      main
+ * purpose:   Runs every check and the performance gate.
+ * arguments: --program PATH    the 40image binary (default ./40image)
+ *            --baseline FILE   compare throughput against this
+ *                              flavour's entry in FILE; without one
+ *                              the gates are skipped with a notice
+ *            --record FILE     record this flavour's throughput into
+ *                              FILE instead
+ *            --tolerance PCT   allowed throughput drop (default 20)
+ *            --flavour NAME    build flavour, recorded with the baseline
+ *            --seed N          random seed
+ * returns:   int - EXIT_SUCCESS if every check passed
+ * Author: Alijah Jackson
+ */
+int main(int argc, char *argv[]) {
+        const char *program = "./40image";
+        const char *baseline = NULL;
+        const char *record = NULL;
+        const char *flavour = "default";
+        double tolerance = 20.0;
+
+        for (int i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "--program") == 0 && i + 1 < argc) {
+                        program = argv[++i];
+                } else if (strcmp(argv[i], "--baseline") == 0 &&
+                           i + 1 < argc) {
+                        baseline = argv[++i];
+                } else if (strcmp(argv[i], "--record") == 0 &&
+                           i + 1 < argc) {
+                        record = argv[++i];
+                } else if (strcmp(argv[i], "--tolerance") == 0 &&
+                           i + 1 < argc) {
+                        tolerance = atof(argv[++i]);
+                } else if (strcmp(argv[i], "--flavour") == 0 &&
+                           i + 1 < argc) {
+                        flavour = argv[++i];
+                } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+                        rng_state = strtoull(argv[++i], NULL, 0) | 1;
+                } else {
+                        fprintf(stderr, "Usage: %s [--program 40image] "
+                                "[--baseline file | --record file] "
+                                "[--tolerance percent] [--flavour name] "
+                                "[--seed n]\n",
+                                argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        char dir[] = "/tmp/check40.XXXXXX";
+        assert(mkdtemp(dir) != NULL);
+
+        int have_program = access(program, X_OK) == 0;
+        if (!have_program) {
+                printf("SKIP %s not found, command-line checks not run\n",
+                       program);
+        }
+
+        check_bulk_bitpack();
+        check_crc32c();
+        for (int s = 0; s < NUM_SIZES; s++) {
+                Image image = random_image(SIZES[s][0], SIZES[s][1]);
+                check_kernels(&image);
+                if (have_program) {
+                        check_cli(&image, program, dir);
+                }
+                free(image.rgb);
+        }
+
+        for (int l = 0; l < NUM_LAYOUTS; l++) {
+                double quality = psnr(total_error[l], total_bytes[l]);
+                char detail[64];
+                snprintf(detail, sizeof(detail), "%s corpus PSNR %.2f dB "
+                         "(floor %.1f)", LAYOUTS[l].name, quality,
+                         PSNR_FLOOR[l]);
+                check(quality >= PSNR_FLOOR[l], detail, NULL,
+                      "below the layout's PSNR floor");
+        }
+
+        char command[128];
+        snprintf(command, sizeof(command), "rm -rf %s", dir);
+        if (system(command) != 0) {
+                fprintf(stderr, "could not remove %s\n", dir);
+        }
+
+        printf("%d of %d checks passed\n", checks - failures, checks);
+        failures += run_perf(baseline, record, flavour, tolerance);
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+******************************  CHECKS **************************
+*/
+
+/*
+ * name:      check_kernels
+ * purpose:   Compares the in-process codec paths for one image against
+ *            the scalar reference: RGB pack and unpack and planar pack
+ *            and unpack must match exactly, and analysis means, block
+ *            variances and histogram totals must match the decoded
+ *            image. The RGB round trip's PSNR is printed and added to
+ *            the corpus totals.
+ * arguments: const Image *image - the (untrimmed) test image
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void check_kernels(const Image *image) {
+        Image trim = trimmed(*image);
+        int width = trim.width, height = trim.height;
+        size_t blocks = (size_t)width * height / 4;
+        char detail[128];
+
+        float *ypbpr = rgb_to_ypbpr(trim.rgb, width, height, 255);
+        Planar planes = reference_planes(&trim);
+
+        for (int l = 0; l < NUM_LAYOUTS; l++) {
+                const Layout *layout = &LAYOUTS[l];
+
+                uint64_t *words = packPixels(ypbpr, width, height, layout);
+                uint64_t *expected = reference_pack(ypbpr, width, height,
+                                                    layout);
+                snprintf(detail, sizeof(detail), "%s packPixels",
+                         layout->name);
+                check(memcmp(words, expected, blocks * 8) == 0, detail,
+                      image, "codewords differ from reference");
+
+                float *decoded = unpackPixels(words, width, height, layout);
+                float *reference = reference_unpack(words, width, height,
+                                                    layout);
+                snprintf(detail, sizeof(detail), "%s unpackPixels",
+                         layout->name);
+                check(memcmp(decoded, reference,
+                             blocks * 12 * sizeof(float)) == 0,
+                      detail, image, "pixels differ from reference");
+
+                uint64_t *planar = packPlanar(planes.y, planes.pb, planes.pr,
+                                              width, height, layout);
+                uint64_t *planar_expected =
+                        reference_pack_planar(&planes, layout);
+                snprintf(detail, sizeof(detail), "%s packPlanar",
+                         layout->name);
+                check(memcmp(planar, planar_expected, blocks * 8) == 0,
+                      detail, image, "codewords differ from reference");
+
+                Planar out = new_planar(width, height);
+                unpackPlanar(words, width, height, out.y, out.pb, out.pr,
+                             layout);
+                int y_ok = 1, chroma_ok = 1;
+                for (size_t i = 0; i < (size_t)width * height; i++) {
+                        float y = reference[3 * i];
+                        y_ok &= out.y[i] == (unsigned char)roundf(
+                                clamp(y, 0, 1) * 255.0f);
+                }
+                for (size_t k = 0; k < blocks; k++) {
+                        unsigned cw = layout->chroma_width;
+                        float pb = reference_chroma(Bitpack_getu(words[k],
+                                        cw, layout->pb_lsb), cw);
+                        float pr = reference_chroma(Bitpack_getu(words[k],
+                                        cw, layout->pr_lsb), cw);
+                        chroma_ok &= out.pb[k] == (unsigned char)roundf(
+                                clamp(pb * 255.0f + 128, 0, 255));
+                        chroma_ok &= out.pr[k] == (unsigned char)roundf(
+                                clamp(pr * 255.0f + 128, 0, 255));
+                }
+                snprintf(detail, sizeof(detail), "%s unpackPlanar Y",
+                         layout->name);
+                check(y_ok, detail, image, "Y plane differs from "
+                      "reference");
+                snprintf(detail, sizeof(detail), "%s unpackPlanar chroma",
+                         layout->name);
+                check(chroma_ok, detail, image, "Pb or Pr plane differs "
+                      "from reference");
+
+                Analysis *analysis = analyze_codewords(words, width, height,
+                                                       layout);
+                double mean_y = 0;
+                for (size_t i = 0; i < (size_t)width * height; i++) {
+                        mean_y += reference[3 * i];
+                }
+                mean_y /= (double)width * height;
+                snprintf(detail, sizeof(detail), "%s analysis mean",
+                         layout->name);
+                check(fabs(mean_y - analysis->mean_y) < 1e-4, detail, image,
+                      "mean Y differs from decoded image");
+
+                /* b^2 + c^2 + d^2 is the variance of the decoded block */
+                int variance_ok = 1;
+                for (size_t k = 0; k < blocks; k++) {
+                        int top = (k / (width / 2)) * 2 * width +
+                                  (k % (width / 2)) * 2;
+                        int corners[4] = { top, top + 1, top + width,
+                                           top + width + 1 };
+                        double mean = 0, variance = 0;
+                        for (int i = 0; i < 4; i++) {
+                                mean += reference[3 * corners[i]] / 4;
+                        }
+                        for (int i = 0; i < 4; i++) {
+                                double diff = reference[3 * corners[i]]
+                                              - mean;
+                                variance += diff * diff / 4;
+                        }
+                        variance_ok &= fabs(variance -
+                                            analysis->variance_map[k]) <
+                                       1e-6 + 1e-4 * variance;
+                }
+                snprintf(detail, sizeof(detail), "%s analysis variance",
+                         layout->name);
+                check(variance_ok, detail, image, "variance map differs "
+                      "from decoded blocks");
+
+                uint64_t totals[4] = { 0, 0, 0, 0 };
+                for (int bin = 0; bin < ANALYSIS_BINS; bin++) {
+                        totals[0] += analysis->hist_y[bin];
+                        for (int c = 0; c < 3; c++) {
+                                totals[c + 1] += analysis->hist_rgb[c][bin];
+                        }
+                }
+                snprintf(detail, sizeof(detail), "%s analysis histograms",
+                         layout->name);
+                check(totals[0] == blocks && totals[1] == blocks &&
+                      totals[2] == blocks && totals[3] == blocks, detail,
+                      image, "histograms do not count every block");
+
+                unsigned char *rgb = ypbpr_to_rgb(decoded, width, height,
+                                                  255);
+                size_t bytes = (size_t)width * height * 3;
+                double error = squared_error(trim.rgb, rgb, bytes);
+                total_error[l] += error;
+                total_bytes[l] += bytes;
+                printf("     %s PSNR %.2f dB (%dx%d)\n", layout->name,
+                       psnr(error, bytes), image->width, image->height);
+
+                free(rgb);
+                free_analysis(analysis);
+                free_planar(&out);
+                free(planar_expected);
+                free(planar);
+                free(reference);
+                free(decoded);
+                free(expected);
+                free(words);
+        }
+
+        free_planar(&planes);
+        free(ypbpr);
+        free(trim.rgb);
+}
+
+/*
+ * name:      check_bulk_bitpack
+ * purpose:   Compares Bitpack_packv and Bitpack_unpackv with the
+ *            single-field Bitpack functions on random fields
+ * arguments: void
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void check_bulk_bitpack(void) {
+        enum { N = 1000, FIELDS = 5 };
+        Bitpack_field fields[FIELDS] = {
+                { 12, 50, false }, { 7, 40, true }, { 1, 39, false },
+                { 20, 19, true }, { 19, 0, false }
+        };
+        int32_t storage[FIELDS][N], unpacked[FIELDS][N];
+        int32_t *values[FIELDS], *outputs[FIELDS];
+        uint64_t words[N];
+        int ok = 1;
+
+        for (int f = 0; f < FIELDS; f++) {
+                values[f] = storage[f];
+                outputs[f] = unpacked[f];
+                for (int i = 0; i < N; i++) {
+                        uint64_t bits = next_random() &
+                                        ((1ULL << fields[f].width) - 1);
+                        storage[f][i] = fields[f].is_signed
+                                ? (int32_t)Bitpack_gets(bits,
+                                                        fields[f].width, 0)
+                                : (int32_t)bits;
+                }
+        }
+
+        Bitpack_packv(words, N, fields, FIELDS, values);
+        Bitpack_unpackv(words, N, fields, FIELDS, outputs);
+        for (int i = 0; i < N; i++) {
+                uint64_t expected = 0;
+                for (int f = 0; f < FIELDS; f++) {
+                        expected = fields[f].is_signed
+                                ? Bitpack_news(expected, fields[f].width,
+                                               fields[f].lsb, storage[f][i])
+                                : Bitpack_newu(expected, fields[f].width,
+                                               fields[f].lsb, storage[f][i]);
+                        ok &= unpacked[f][i] == storage[f][i];
+                }
+                ok &= words[i] == expected;
+        }
+        check(ok, "bulk Bitpack", NULL, "differs from Bitpack_new/get");
+}
+
+/*
+ * name:      check_crc32c
+ * purpose:   Compares crc32c, whichever path the CPU selects, with the
+ *            standard check value and a bit-at-a-time reference over
+ *            random lengths and alignments, chained and in one call
+ * arguments: void
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void check_crc32c(void) {
+        enum { N = 256 };
+        unsigned char data[N + 8];
+        int ok = crc32c(0, (const unsigned char *)"123456789", 9) ==
+                 0xE3069283u;
+
+        for (int i = 0; i < N + 8; i++) {
+                data[i] = (unsigned char)next_random();
+        }
+        for (int trial = 0; trial < 200; trial++) {
+                size_t offset = next_random() % 8;
+                size_t length = next_random() % (N + 1);
+                size_t split = length == 0 ? 0 : next_random() % length;
+                uint32_t expected = 0xFFFFFFFFu;
+                for (size_t i = 0; i < length; i++) {
+                        expected ^= data[offset + i];
+                        for (int bit = 0; bit < 8; bit++) {
+                                expected = (expected >> 1) ^
+                                           (0x82F63B78u & -(expected & 1));
+                        }
+                }
+                expected = ~expected;
+                uint32_t head = crc32c(0, data + offset, split);
+                ok &= crc32c(0, data + offset, length) == expected;
+                ok &= crc32c(head, data + offset + split,
+                             length - split) == expected;
+        }
+        check(ok, "crc32c", NULL, "differs from the bitwise reference");
+}
+
+/*
+ * name:      check_cli
+ * purpose:   Runs the 40image container and re-encode paths on one image
+ *            and compares them with the plain format: segmented output
+ *            must decode identically, and an incremental re-encode must
+ *            produce the same file as a full encode. The I420 input and
+ *            output paths and -a must match files built in-process from
+ *            the same planes, and a segmented file with a corrupt
+ *            segment must make -d and -u fail and name the segment,
+ *            with -u leaving the file untouched.
+ * arguments: const Image *image - the test image
+ *            const char *program - path of the 40image binary
+ *            const char *dir - scratch directory
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void check_cli(const Image *image, const char *program,
+                      const char *dir) {
+        char command[1024], detail[64], size[32];
+        const char *steps[][2] = {
+                /*
+                 * name, shell command with %1$s the program, %2$s the
+                 * scratch directory, %3$s the layout option and %4$s the
+                 * untrimmed size as WxH
+                 */
+                { "segmented decode",
+                  "%1$s -c %3$s %2$s/a.ppm > %2$s/plain && "
+                  "%1$s -c -s %3$s %2$s/a.ppm > %2$s/seg && "
+                  "%1$s -d %2$s/plain > %2$s/plain.ppm && "
+                  "%1$s -d %2$s/seg > %2$s/seg.ppm && "
+                  "cmp -s %2$s/plain.ppm %2$s/seg.ppm" },
+                { "incremental re-encode",
+                  "%1$s -c %3$s %2$s/a.ppm > %2$s/inc && "
+                  "%1$s -c %3$s %2$s/b.ppm > %2$s/full && "
+                  "%1$s -u %2$s/a.ppm %2$s/inc %2$s/b.ppm && "
+                  "cmp -s %2$s/inc %2$s/full" },
+                { "incremental segmented re-encode",
+                  "%1$s -c -s %3$s %2$s/a.ppm > %2$s/inc && "
+                  "%1$s -c -s %3$s %2$s/b.ppm > %2$s/full && "
+                  "%1$s -u %2$s/a.ppm %2$s/inc %2$s/b.ppm && "
+                  "cmp -s %2$s/inc %2$s/full" },
+                { "I420 compress",
+                  "%1$s -c %3$s --i420-size %4$s %2$s/a.yuv > %2$s/yuv && "
+                  "cmp -s %2$s/yuv %2$s/expected" },
+                { "I420 decompress",
+                  "%1$s -d --i420 %2$s/expected > %2$s/yuv && "
+                  "cmp -s %2$s/yuv %2$s/expected.yuv" },
+                { "analysis",
+                  "%1$s -a %2$s/expected > %2$s/analysis && "
+                  "cmp -s %2$s/analysis %2$s/expected.txt" },
+                { "corrupt segment decode",
+                  "! %1$s -d %2$s/bad > /dev/null 2> %2$s/err && "
+                  "grep -q '^Segment 0 (' %2$s/err" },
+                { "corrupt segment re-encode",
+                  "cp %2$s/bad %2$s/inc && "
+                  "! %1$s -u %2$s/a.ppm %2$s/inc %2$s/b.ppm 2> %2$s/err && "
+                  "grep -q '^Segment 0 (' %2$s/err && "
+                  "cmp -s %2$s/bad %2$s/inc" },
+        };
+
+        /* b.ppm is a.ppm with a patch in its top-left corner changed */
+        for (int version = 0; version < 2; version++) {
+                snprintf(command, sizeof(command), "%s/%c.ppm", dir,
+                         'a' + version);
+                FILE *fp = fopen(command, "wb");
+                assert(fp != NULL);
+                fprintf(fp, "P6\n%d %d\n255\n", image->width,
+                        image->height);
+                for (int i = 0; i < image->width * image->height * 3; i++) {
+                        int row = i / 3 / image->width;
+                        int col = i / 3 % image->width;
+                        int patched = version == 1 && row < 3 && col < 5;
+                        fputc(patched ? 255 - image->rgb[i] : image->rgb[i],
+                              fp);
+                }
+                fclose(fp);
+        }
+        snprintf(command, sizeof(command), "%s/a.yuv", dir);
+        write_i420(image, command);
+        snprintf(size, sizeof(size), "%dx%d", image->width, image->height);
+        Planar planes = trimmed_i420(image);
+
+        for (int l = 0; l < NUM_LAYOUTS; l++) {
+                char layout_option[32];
+                snprintf(layout_option, sizeof(layout_option), "-l %s",
+                         LAYOUTS[l].name);
+                write_expected(&planes, &LAYOUTS[l], dir);
+
+                /* bad is a segmented a.ppm with segment 0 corrupted */
+                snprintf(command, sizeof(command),
+                         "%s -c -s %s %s/a.ppm > %s/bad", program,
+                         layout_option, dir, dir);
+                int corrupted = system(command) == 0;
+                snprintf(command, sizeof(command), "%s/bad", dir);
+                corrupted = corrupted && corrupt_segment(command, 0);
+
+                for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]);
+                     s++) {
+                        snprintf(command, sizeof(command), steps[s][1],
+                                 program, dir, layout_option, size);
+                        snprintf(detail, sizeof(detail), "%s %s",
+                                 LAYOUTS[l].name, steps[s][0]);
+                        check(corrupted && system(command) == 0, detail,
+                              image, "command failed or output differs");
+                }
+        }
+        free_planar(&planes);
+}
+
+/*
+ * name:      write_i420
+ * purpose:   Writes an untrimmed raw I420 file for an image, with chroma
+ *            planes of half the size rounded up as read_i420 expects.
+ *            The planes are filled straight from the RGB bytes (R as Y,
+ *            the top-left pixel's G and B as Pb and Pr), since only the
+ *            bytes matter here.
+ * arguments: const Image *image - the (untrimmed) test image
+ *            const char *path - file to write
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void write_i420(const Image *image, const char *path) {
+        int chroma_width = (image->width + 1) / 2;
+        int chroma_height = (image->height + 1) / 2;
+        FILE *fp = fopen(path, "wb");
+        assert(fp != NULL);
+
+        for (int i = 0; i < image->width * image->height; i++) {
+                fputc(image->rgb[3 * i], fp);
+        }
+        for (int plane = 1; plane <= 2; plane++) {
+                for (int row = 0; row < chroma_height; row++) {
+                        for (int col = 0; col < chroma_width; col++) {
+                                int pixel = 2 * row * image->width + 2 * col;
+                                fputc(image->rgb[3 * pixel + plane], fp);
+                        }
+                }
+        }
+        fclose(fp);
+}
+
+/*
+ * name:      trimmed_i420
+ * purpose:   Builds the planes read_i420 should return for the file
+ *            written by write_i420: every plane trimmed to the even size,
+ *            with each chroma row cut short of its rounded-up width
+ * arguments: const Image *image - the (untrimmed) test image
+ * returns:   Planar - the trimmed planes
+ * Author: Alijah Jackson
+ */
+static Planar trimmed_i420(const Image *image) {
+        Planar planes = new_planar(image->width & ~1, image->height & ~1);
+        int chroma_width = planes.width / 2;
+
+        for (int row = 0; row < planes.height; row++) {
+                for (int col = 0; col < planes.width; col++) {
+                        planes.y[row * planes.width + col] =
+                                image->rgb[3 * (row * image->width + col)];
+                }
+        }
+        for (int row = 0; row < planes.height / 2; row++) {
+                for (int col = 0; col < chroma_width; col++) {
+                        int pixel = 2 * row * image->width + 2 * col;
+                        planes.pb[row * chroma_width + col] =
+                                image->rgb[3 * pixel + 1];
+                        planes.pr[row * chroma_width + col] =
+                                image->rgb[3 * pixel + 2];
+                }
+        }
+        return planes;
+}
+
+/*
+ * name:      write_expected
+ * purpose:   Writes what 40image should print for the planes in one
+ *            layout: "expected" is the compressed file from the
+ *            reference planar pack, "expected.yuv" its I420 decode and
+ *            "expected.txt" its analysis
+ * arguments: const Planar *planes - the trimmed planes
+ *            const Layout *layout - codeword layout
+ *            const char *dir - scratch directory
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void write_expected(const Planar *planes, const Layout *layout,
+                           const char *dir) {
+        char path[256];
+        int width = planes->width, height = planes->height;
+        size_t blocks = (size_t)(width / 2) * (height / 2);
+        uint64_t *words = reference_pack_planar(planes, layout);
+
+        snprintf(path, sizeof(path), "%s/expected", dir);
+        FILE *fp = fopen(path, "wb");
+        assert(fp != NULL);
+        fprintf(fp, "%s\n%u %u\n", layout->header, width, height);
+        for (size_t i = 0; i < blocks; i++) {
+                for (int shift = 56; shift >= 0; shift -= 8) {
+                        fputc((words[i] >> shift) & 0xFF, fp);
+                }
+        }
+        fclose(fp);
+
+        Planar decoded = new_planar(width, height);
+        unpackPlanar(words, width, height, decoded.y, decoded.pb,
+                     decoded.pr, layout);
+        snprintf(path, sizeof(path), "%s/expected.yuv", dir);
+        fp = fopen(path, "wb");
+        assert(fp != NULL);
+        fwrite(decoded.y, 1, (size_t)width * height, fp);
+        fwrite(decoded.pb, 1, blocks, fp);
+        fwrite(decoded.pr, 1, blocks, fp);
+        fclose(fp);
+        free_planar(&decoded);
+
+        Analysis *analysis = analyze_codewords(words, width, height, layout);
+        snprintf(path, sizeof(path), "%s/expected.txt", dir);
+        fp = fopen(path, "w");
+        assert(fp != NULL);
+        print_analysis(fp, analysis);
+        fclose(fp);
+        free_analysis(analysis);
+        free(words);
+}
+
+/*
+ * name:      corrupt_segment
+ * purpose:   Flips one bit in the middle of a segment's payload in a
+ *            segmented file, leaving the table and its checksums alone
+ * arguments: const char *path - the segmented file
+ *            int segment - index of the segment to corrupt
+ * returns:   int - 1 if the file was corrupted, 0 if it could not be read
+ * Author: Alijah Jackson
+ */
+static int corrupt_segment(const char *path, int segment) {
+        char header[64], info[SEGMENT_INFO_SIZE];
+        const Layout *layout;
+        int width, height, count;
+        FILE *fp = fopen(path, "r+b");
+        if (fp == NULL) {
+                return 0;
+        }
+        int ok = fgets(header, sizeof(header), fp) != NULL &&
+                 Segment_read_info(fp, info, &layout, &width, &height,
+                                   &count) &&
+                 segment < count;
+        Segment *segments = malloc(count * sizeof(Segment) + 1);
+        assert(segments != NULL);
+        ok = ok && Segment_read_table(fp, info, segments, count);
+
+        if (ok) {
+                long offset = ftell(fp) + segments[segment].length / 2;
+                for (int s = 0; s < segment; s++) {
+                        offset += segments[s].length;
+                }
+                fseek(fp, offset, SEEK_SET);
+                int byte = fgetc(fp);
+                fseek(fp, offset, SEEK_SET);
+                ok = byte != EOF && fputc(byte ^ 0x10, fp) != EOF;
+        }
+        free(segments);
+        fclose(fp);
+        return ok;
+}
+
+/*
+ * name:      run_perf
+ * purpose:   Measures encode (rgb_to_ypbpr + packPixels) and decode
+ *            (unpackPixels + ypbpr_to_rgb) throughput on a fixed
+ *            synthetic corpus, best of several runs, and either records
+ *            it or compares it with a recorded baseline. A baseline only
+ *            applies to the build flavour it was recorded from; with no
+ *            baseline for this flavour the gates are skipped, since
+ *            throughput depends on the machine and cannot be shipped.
+ * arguments: const char *baseline - baseline file to compare with, or NULL
+ *            const char *record - file to record into, or NULL
+ *            const char *flavour - name of the build flavour
+ *            double tolerance - allowed drop, in percent
+ * returns:   int - number of gates that failed
+ * Author: Alijah Jackson
+ */
+static int run_perf(const char *baseline, const char *record,
+                    const char *flavour, double tolerance) {
+        double best[2] = { 0, 0 };
+        size_t bytes = (size_t)PERF_WIDTH * PERF_HEIGHT * 3 * PERF_IMAGES;
+        Image corpus[PERF_IMAGES];
+        const Layout *layout = &LAYOUTS[LAYOUT_format2];
+
+        rng_state = 0x5EED40ULL;
+        for (int i = 0; i < PERF_IMAGES; i++) {
+                corpus[i] = random_image(PERF_WIDTH, PERF_HEIGHT);
+        }
+
+        for (int repeat = 0; repeat < PERF_REPEATS; repeat++) {
+                double seconds[2] = { 0, 0 };
+                for (int i = 0; i < PERF_IMAGES; i++) {
+                        struct timespec t0, t1, t2;
+                        clock_gettime(CLOCK_MONOTONIC, &t0);
+                        float *ypbpr = rgb_to_ypbpr(corpus[i].rgb,
+                                                    PERF_WIDTH, PERF_HEIGHT,
+                                                    255);
+                        uint64_t *words = packPixels(ypbpr, PERF_WIDTH,
+                                                     PERF_HEIGHT, layout);
+                        clock_gettime(CLOCK_MONOTONIC, &t1);
+                        float *decoded = unpackPixels(words, PERF_WIDTH,
+                                                      PERF_HEIGHT, layout);
+                        unsigned char *rgb = ypbpr_to_rgb(decoded,
+                                                          PERF_WIDTH,
+                                                          PERF_HEIGHT, 255);
+                        clock_gettime(CLOCK_MONOTONIC, &t2);
+
+                        seconds[0] += (t1.tv_sec - t0.tv_sec) +
+                                      (t1.tv_nsec - t0.tv_nsec) / 1e9;
+                        seconds[1] += (t2.tv_sec - t1.tv_sec) +
+                                      (t2.tv_nsec - t1.tv_nsec) / 1e9;
+                        free(rgb);
+                        free(decoded);
+                        free(words);
+                        free(ypbpr);
+                }
+                for (int k = 0; k < 2; k++) {
+                        double rate = bytes / seconds[k] / 1e6;
+                        best[k] = rate > best[k] ? rate : best[k];
+                }
+        }
+        for (int i = 0; i < PERF_IMAGES; i++) {
+                free(corpus[i].rgb);
+        }
+
+        printf("encode %.2f MB/s, decode %.2f MB/s\n", best[0], best[1]);
+
+        if (record != NULL) {
+                record_baseline(record, flavour, best);
+                printf("recorded %s baseline in %s\n", flavour, record);
+                return 0;
+        }
+
+        double expected[2];
+        if (baseline == NULL) {
+                return 0;
+        }
+        if (!read_baseline(baseline, flavour, expected)) {
+                printf("SKIP performance gates: no %s baseline in %s, "
+                       "run make check-baseline to record one\n", flavour,
+                       baseline);
+                return 0;
+        }
+
+        int failed = 0;
+        const char *names[2] = { "encode", "decode" };
+        for (int k = 0; k < 2; k++) {
+                double floor = expected[k] * (1 - tolerance / 100);
+                int ok = best[k] >= floor;
+                printf("%s %s: %.2f MB/s vs baseline %.2f MB/s "
+                       "(floor %.2f)\n", ok ? "PASS" : "FAIL", names[k],
+                       best[k], expected[k], floor);
+                failed += !ok;
+        }
+        return failed;
+}
+
+/*
+ * name:      read_baseline
+ * purpose:   Looks up one build flavour in a baseline file, which holds
+ *            a line "<flavour> encode <MB/s> decode <MB/s>" per flavour
+ * arguments: const char *path - the baseline file
+ *            const char *flavour - name of the build flavour
+ *            double expected[2] - where to store encode and decode MB/s
+ * returns:   int - 1 if the flavour has an entry, 0 otherwise
+ * Author: Alijah Jackson
+ */
+static int read_baseline(const char *path, const char *flavour,
+                         double expected[2]) {
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) {
+                return 0;
+        }
+        char line[256], name[64];
+        int found = 0;
+        while (!found && fgets(line, sizeof(line), fp) != NULL) {
+                found = sscanf(line, "%63s encode %lf decode %lf", name,
+                               &expected[0], &expected[1]) == 3 &&
+                        strcmp(name, flavour) == 0;
+        }
+        fclose(fp);
+        return found;
+}
+
+/*
+ * name:      record_baseline
+ * purpose:   Writes one build flavour's entry into a baseline file,
+ *            replacing any earlier entry for it and keeping the others
+ * arguments: const char *path - the baseline file
+ *            const char *flavour - name of the build flavour
+ *            const double best[2] - encode and decode MB/s
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void record_baseline(const char *path, const char *flavour,
+                            const double best[2]) {
+        enum { MAX_FLAVOURS = 16 };
+        char kept[MAX_FLAVOURS][256], name[64];
+        double rates[2];
+        int count = 0;
+
+        FILE *fp = fopen(path, "r");
+        if (fp != NULL) {
+                while (count < MAX_FLAVOURS &&
+                       fgets(kept[count], sizeof(kept[count]), fp) != NULL) {
+                        if (sscanf(kept[count], "%63s encode %lf decode %lf",
+                                   name, &rates[0], &rates[1]) == 3 &&
+                            strcmp(name, flavour) != 0) {
+                                count++;
+                        }
+                }
+                fclose(fp);
+        }
+
+        fp = fopen(path, "w");
+        assert(fp != NULL);
+        for (int i = 0; i < count; i++) {
+                fputs(kept[i], fp);
+        }
+        fprintf(fp, "%s encode %.2f decode %.2f\n", flavour, best[0],
+                best[1]);
+        fclose(fp);
+}
+
+/*
+******************************  REFERENCE **************************
+*/
+
+/*
+ * name:      reference_pack
+ * purpose:   Scalar reference encoder: the original per-block packing
+ *            loop with every field inserted by Bitpack_newu/news
+ * arguments: const float *ypbpr - YPbPr image data
+ *            int width, int height - dimensions of the image
+ *            const Layout *layout - codeword layout
+ * returns:   uint64_t* - one codeword per block
+ * Author: Alijah Jackson
+ */
+static uint64_t *reference_pack(const float *ypbpr, int width, int height,
+                                const Layout *layout) {
+        int blocks = width * height / 4;
+        uint64_t *words = malloc(blocks * sizeof(uint64_t) + 1);
+        unsigned a_max = (1u << layout->a_width) - 1;
+        int bcd_max = (1 << (layout->bcd_width - 1)) - 1;
+
+        for (int k = 0; k < blocks; k++) {
+                int base = ((k / (width / 2)) * 2 * width +
+                            (k % (width / 2)) * 2) * 3;
+                float block[4][3];
+                for (int i = 0; i < 4; i++) {
+                        int idx = base + (i / 2) * width * 3 + (i % 2) * 3;
+                        block[i][0] = ypbpr[idx];
+                        block[i][1] = ypbpr[idx + 1];
+                        block[i][2] = ypbpr[idx + 2];
+                }
+                float *chroma = chromaBlockAverages(block);
+                float y[4] = { block[0][0], block[1][0], block[2][0],
+                               block[3][0] };
+                float *coefs = pixelsToCoefficients(y);
+
+                unsigned a = (unsigned)roundf(coefs[0] * (float)a_max);
+                a = (a > a_max) ? a_max : a;
+                uint64_t word = Bitpack_newu(0, layout->a_width,
+                                             layout->a_lsb, a);
+                unsigned lsbs[3] = { layout->b_lsb, layout->c_lsb,
+                                     layout->d_lsb };
+                for (int f = 0; f < 3; f++) {
+                        int value = clamp((int)roundf(coefs[f + 1] /
+                                          BCD_RANGE * (float)bcd_max),
+                                          -bcd_max, bcd_max);
+                        word = Bitpack_news(word, layout->bcd_width, lsbs[f],
+                                            value);
+                }
+                word = Bitpack_newu(word, layout->chroma_width,
+                                    layout->pb_lsb,
+                                    reference_chroma_index(chroma[0],
+                                            layout->chroma_width));
+                word = Bitpack_newu(word, layout->chroma_width,
+                                    layout->pr_lsb,
+                                    reference_chroma_index(chroma[1],
+                                            layout->chroma_width));
+                words[k] = word;
+                free(chroma);
+                free(coefs);
+        }
+        return words;
+}
+
+/*
+ * name:      reference_unpack
+ * purpose:   Scalar reference decoder: every field extracted with
+ *            Bitpack_getu/gets and dequantized one block at a time
+ * arguments: const uint64_t *codewords - one codeword per block
+ *            int width, int height - dimensions of the image
+ *            const Layout *layout - codeword layout
+ * returns:   float* - YPbPr image data
+ * Author: Alijah Jackson
+ */
+static float *reference_unpack(const uint64_t *codewords, int width,
+                               int height, const Layout *layout) {
+        int blocks = width * height / 4;
+        float *ypbpr = malloc((size_t)width * height * 3 * sizeof(float)
+                              + 1);
+        float a_scale = (float)((1u << layout->a_width) - 1);
+        float bcd_scale = (float)((1 << (layout->bcd_width - 1)) - 1);
+
+        for (int k = 0; k < blocks; k++) {
+                uint64_t word = codewords[k];
+                float coefs[4] = {
+                        Bitpack_getu(word, layout->a_width, layout->a_lsb)
+                                / a_scale,
+                        Bitpack_gets(word, layout->bcd_width, layout->b_lsb)
+                                * BCD_RANGE / bcd_scale,
+                        Bitpack_gets(word, layout->bcd_width, layout->c_lsb)
+                                * BCD_RANGE / bcd_scale,
+                        Bitpack_gets(word, layout->bcd_width, layout->d_lsb)
+                                * BCD_RANGE / bcd_scale
+                };
+                float *pixels = coefficientsToPixels(coefs);
+                float pb = reference_chroma(Bitpack_getu(word,
+                                layout->chroma_width, layout->pb_lsb),
+                                layout->chroma_width);
+                float pr = reference_chroma(Bitpack_getu(word,
+                                layout->chroma_width, layout->pr_lsb),
+                                layout->chroma_width);
+
+                for (int i = 0; i < 4; i++) {
+                        int row = (k / (width / 2)) * 2 + i / 2;
+                        int col = (k % (width / 2)) * 2 + i % 2;
+                        int idx = (row * width + col) * 3;
+                        ypbpr[idx] = pixels[i];
+                        ypbpr[idx + 1] = pb;
+                        ypbpr[idx + 2] = pr;
+                }
+                free(pixels);
+        }
+        return ypbpr;
+}
+
+/*
+ * name:      reference_planes
+ * purpose:   Builds 8-bit I420 planes from an RGB image, averaging
+ *            chroma over each 2x2 block
+ * arguments: const Image *image - even-sized RGB image
+ * returns:   Planar - the planes
+ * Author: Alijah Jackson
+ */
+static Planar reference_planes(const Image *image) {
+        Planar planes = new_planar(image->width, image->height);
+        float *ypbpr = rgb_to_ypbpr(image->rgb, image->width, image->height,
+                                    255);
+        int block_width = image->width / 2;
+
+        for (int i = 0; i < image->width * image->height; i++) {
+                planes.y[i] = (unsigned char)roundf(clamp(ypbpr[3 * i], 0, 1)
+                                                    * 255.0f);
+        }
+        for (int k = 0; k < block_width * (image->height / 2); k++) {
+                int top = (k / block_width) * 2 * image->width +
+                          (k % block_width) * 2;
+                int corners[4] = { top, top + 1, top + image->width,
+                                   top + image->width + 1 };
+                float pb = 0, pr = 0;
+                for (int i = 0; i < 4; i++) {
+                        pb += ypbpr[3 * corners[i] + 1] / 4;
+                        pr += ypbpr[3 * corners[i] + 2] / 4;
+                }
+                planes.pb[k] = (unsigned char)roundf(clamp(pb * 255 + 128,
+                                                           0, 255));
+                planes.pr[k] = (unsigned char)roundf(clamp(pr * 255 + 128,
+                                                           0, 255));
+        }
+        free(ypbpr);
+        return planes;
+}
+
+/*
+ * name:      reference_pack_planar
+ * purpose:   Scalar reference for packPlanar, inserting every field with
+ *            Bitpack_newu/news
+ * arguments: const Planar *planes - the planes to pack
+ *            const Layout *layout - codeword layout
+ * returns:   uint64_t* - one codeword per block
+ * Author: Alijah Jackson
+ */
+static uint64_t *reference_pack_planar(const Planar *planes,
+                                       const Layout *layout) {
+        int width = planes->width;
+        int blocks = width * planes->height / 4;
+        uint64_t *words = malloc(blocks * sizeof(uint64_t) + 1);
+        unsigned a_max = (1u << layout->a_width) - 1;
+        int bcd_max = (1 << (layout->bcd_width - 1)) - 1;
+
+        for (int k = 0; k < blocks; k++) {
+                int top = (k / (width / 2)) * 2 * width + (k % (width / 2))
+                          * 2;
+                float y[4] = { planes->y[top] / 255.0f,
+                               planes->y[top + 1] / 255.0f,
+                               planes->y[top + width] / 255.0f,
+                               planes->y[top + width + 1] / 255.0f };
+                float *coefs = pixelsToCoefficients(y);
+
+                unsigned a = (unsigned)roundf(coefs[0] * (float)a_max);
+                a = (a > a_max) ? a_max : a;
+                uint64_t word = Bitpack_newu(0, layout->a_width,
+                                             layout->a_lsb, a);
+                unsigned lsbs[3] = { layout->b_lsb, layout->c_lsb,
+                                     layout->d_lsb };
+                for (int f = 0; f < 3; f++) {
+                        int value = clamp((int)roundf(coefs[f + 1] /
+                                          BCD_RANGE * (float)bcd_max),
+                                          -bcd_max, bcd_max);
+                        word = Bitpack_news(word, layout->bcd_width, lsbs[f],
+                                            value);
+                }
+                float pb = clamp((planes->pb[k] - 128) / 255.0f, -0.5f, 0.5f);
+                float pr = clamp((planes->pr[k] - 128) / 255.0f, -0.5f, 0.5f);
+                word = Bitpack_newu(word, layout->chroma_width,
+                                    layout->pb_lsb,
+                                    reference_chroma_index(pb,
+                                            layout->chroma_width));
+                word = Bitpack_newu(word, layout->chroma_width,
+                                    layout->pr_lsb,
+                                    reference_chroma_index(pr,
+                                            layout->chroma_width));
+                words[k] = word;
+                free(coefs);
+        }
+        return words;
+}
+
+/*
+ * name:      reference_chroma_index / reference_chroma
+ * purpose:   Map chroma to and from an index: the Arith40 table for
+ *            4-bit fields, linear steps over [-0.5, 0.5] otherwise
+ * arguments: float value / unsigned index - value or index to map
+ *            unsigned width - chroma field width
+ * returns:   unsigned index / float value
+ * Author: Alijah Jackson
+ */
+static unsigned reference_chroma_index(float value, unsigned width) {
+        if (width == 4) return Arith40_index_of_chroma(value);
+        return (unsigned)roundf((value + 0.5f) *
+                                (float)((1u << width) - 1));
+}
+
+static float reference_chroma(unsigned index, unsigned width) {
+        if (width == 4) return Arith40_chroma_of_index(index);
+        return index / (float)((1u << width) - 1) - 0.5f;
+}
+
+/*
+******************************  HELPER FUNCTIONS **************************
+*/
+
+/*
+ * name:      next_random
+ * purpose:   xorshift64 generator, so runs are repeatable from a seed
+ * arguments: void
+ * returns:   uint64_t - next random value
+ * Author: Alijah Jackson
+ */
+static uint64_t next_random(void) {
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+        return rng_state;
+}
+
+/*
+ * name:      random_image
+ * purpose:   Makes a test image: a random color gradient with mild noise
+ *            and a few sharp-edged rectangles, so both smooth areas and
+ *            saturating edges are covered
+ * arguments: int width, int height - dimensions of the image
+ * returns:   Image - the image, maxval 255
+ * Author: Alijah Jackson
+ */
+static Image random_image(int width, int height) {
+        Image image = { width, height, malloc((size_t)width * height * 3) };
+        int start[3], slope_x[3], slope_y[3];
+        assert(image.rgb != NULL);
+
+        for (int c = 0; c < 3; c++) {
+                start[c] = next_random() % 256;
+                slope_x[c] = (int)(next_random() % 9) - 4;
+                slope_y[c] = (int)(next_random() % 9) - 4;
+        }
+        for (int row = 0; row < height; row++) {
+                for (int col = 0; col < width; col++) {
+                        for (int c = 0; c < 3; c++) {
+                                int value = start[c] + (slope_x[c] * col +
+                                            slope_y[c] * row) / 4 +
+                                            (int)(next_random() % 9) - 4;
+                                value = ((value % 512) + 512) % 512;
+                                value = value > 255 ? 511 - value : value;
+                                image.rgb[((size_t)row * width + col) * 3
+                                          + c] = value;
+                        }
+                }
+        }
+        for (int r = 0; r < 3; r++) {
+                int x0 = next_random() % width, y0 = next_random() % height;
+                int x1 = x0 + next_random() % (width - x0 + 1);
+                int y1 = y0 + next_random() % (height - y0 + 1);
+                unsigned char color[3] = { next_random() % 256,
+                                           next_random() % 256,
+                                           next_random() % 256 };
+                for (int row = y0; row < y1; row++) {
+                        for (int col = x0; col < x1; col++) {
+                                memcpy(image.rgb + ((size_t)row * width +
+                                       col) * 3, color, 3);
+                        }
+                }
+        }
+        return image;
+}
+
+/*
+ * name:      trimmed
+ * purpose:   Copies an image trimmed to even dimensions, as read_ppm does
+ * arguments: Image image - the image to trim
+ * returns:   Image - the trimmed copy
+ * Author: Alijah Jackson
+ */
+static Image trimmed(Image image) {
+        Image trim = image;
+        trim.rgb = trim_ppm(image.rgb, &trim.width, &trim.height);
+        return trim;
+}
+
+/*
+ * name:      squared_error / psnr
+ * purpose:   Sum of squared differences between two 8-bit buffers, and
+ *            the peak signal-to-noise ratio it gives
+ * arguments: const unsigned char *a, *b - the buffers
+ *            double error - sum of squared differences
+ *            size_t n - number of bytes
+ * returns:   double - the sum / PSNR in dB (100 for no error)
+ * Author: Alijah Jackson
+ */
+static double squared_error(const unsigned char *a, const unsigned char *b,
+                            size_t n) {
+        double error = 0;
+        for (size_t i = 0; i < n; i++) {
+                double diff = (double)a[i] - b[i];
+                error += diff * diff;
+        }
+        return error;
+}
+
+static double psnr(double error, size_t n) {
+        if (error == 0 || n == 0) return 100.0;
+        return 10 * log10(255.0 * 255.0 / (error / n));
+}
+
+/*
+ * name:      check
+ * purpose:   Records and prints the outcome of one check
+ * arguments: int ok - whether the check passed
+ *            const char *name - what was checked
+ *            const Image *image - image it was checked on, or NULL
+ *            const char *detail - explanation printed on failure
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void check(int ok, const char *name, const Image *image,
+                  const char *detail) {
+        checks++;
+        if (image != NULL) {
+                printf("%s %s (%dx%d)%s%s\n", ok ? "PASS" : "FAIL", name,
+                       image->width, image->height, ok ? "" : ": ",
+                       ok ? "" : detail);
+        } else {
+                printf("%s %s%s%s\n", ok ? "PASS" : "FAIL", name,
+                       ok ? "" : ": ", ok ? "" : detail);
+        }
+        failures += !ok;
+}
@@ -0,0 +1,27 @@
+/* codec40.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the codec options that go beyond the compress40 and
+ * decompress40 entry points declared in compress40.h.
+ */
+
+#ifndef CODEC40_H
+#define CODEC40_H
+
+#include <stdio.h>
+
+#include <layout.h>
+
+void compress40_layout(const Layout *layout);
+void compress40_segmented(int segment_rows);
+void compress40_i420(int width, int height);
+void decompress40_i420(void);
+
+void recompress40_files(const char *old_ppm, const char *compressed);
+void recompress40(FILE *input);
+
+void analyze40_variance_map(const char *path);
+void analyze40(FILE *input);
+
+#endif
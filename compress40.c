@@ -12,6 +12,80 @@
 #include <reader.h>
 #include <transforms.h>
 #include <quan.h>
+#include <stats.h>
+#include <codec40.h>
+#include <segment.h>
+#include <planar.h>
+
+static const Layout *output_layout = &LAYOUTS[LAYOUT_format2];
+static int output_segment_rows = 0;
+static int input_i420 = 0;
+static int input_i420_width = 0;
+static int input_i420_height = 0;
+static int output_i420 = 0;
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static uint64_t *pack_ppm(FILE *input, int *width, int *height);
+static uint64_t *pack_i420(FILE *input, int *width, int *height);
+static void unpack_i420(const uint64_t *codewords, int width, int height,
+                        const Layout *layout);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      compress40_layout
+ * purpose:   Selects the codeword layout used by compress40. The default
+ *            is format2.
+ * arguments: const Layout *layout - layout for compressed output
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void compress40_layout(const Layout *layout) {
+        output_layout = layout;
+}
+
+/*
+ * name:      compress40_segmented
+ * purpose:   Makes compress40 write the segmented format instead of the
+ *            plain one.
+ * arguments: int segment_rows - block rows per segment, or 0 for the
+ *                               plain format
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void compress40_segmented(int segment_rows) {
+        output_segment_rows = segment_rows;
+}
+
+/*
+ * name:      compress40_i420
+ * purpose:   Makes compress40 read raw I420 input of the given size
+ *            instead of a PPM image.
+ * arguments: int width, int height - dimensions of the Y plane
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void compress40_i420(int width, int height) {
+        input_i420 = 1;
+        input_i420_width = width;
+        input_i420_height = height;
+}
+
+/*
+ * name:      decompress40_i420
+ * purpose:   Makes decompress40 print raw I420 instead of a PPM image.
+ * arguments: void
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void decompress40_i420(void) {
+        output_i420 = 1;
+}
 
 /*
  * name:      compress40
@@ -19,21 +93,30 @@
  *            packing the pixels into codewords, and printing the compressed
  *            data. This function reads the PPM image, transforms the color
  *            space, packs the pixels into codewords, and outputs the compressed
- *            image.
+ *            image. With compress40_i420 set, the input is raw I420 and
+ *            is packed directly.
  * arguments: FILE *input - the input file pointer to the PPM image.
  * returns:   void
  * Author: Alijah Jackson
  */
 void compress40(FILE *input){
-        size_t size = 0;
-        int width, height, maxVal;
-        
-        PPMData ppmdata = read_ppm(input, &size, &maxVal, &width, &height);
+        int width, height;
+        uint64_t* codewords;
 
-        float* chromaValues = rgb_to_ypbpr(ppmdata, width, height, maxVal);
-        uint64_t* codewords = packPixels(chromaValues, width, height);
+        if (input_i420) {
+                codewords = pack_i420(input, &width, &height);
+        } else {
+                codewords = pack_ppm(input, &width, &height);
+        }
 
-        printCompressed(codewords, width, height);
+        STATS_BEGIN(STATS_WRITE);
+        if (output_segment_rows > 0) {
+                printSegmented(codewords, width, height, output_layout,
+                               output_segment_rows);
+        } else {
+                printCompressed(codewords, width, height, output_layout);
+        }
+        STATS_END(STATS_WRITE);
 }
 
 /*
@@ -42,7 +125,9 @@ void compress40(FILE *input){
  *            data, unpacking the codewords into YPbPr values, converting them
  *            back to RGB, and printing the PPM image. This function reads the
  *            compressed image, unpacks the codewords, transforms the color
- *            space back to RGB, and outputs the decompressed image.
+ *            space back to RGB, and outputs the decompressed image. With
+ *            decompress40_i420 set, the codewords are unpacked straight to
+ *            planar I420 instead.
  * arguments: FILE *input - the input file pointer to the compressed image.
  * returns:   void
  * Author: Alijah Jackson
@@ -50,11 +135,111 @@ void compress40(FILE *input){
 void decompress40(FILE *input){
         size_t size = 0;
         int width, height;
+        const Layout *layout;
 
-        uint64_t * codewords = read_compressed(input, &size, &width, &height);
-        
-        float * ypbpr = unpackPixels(codewords, width, height);
+        STATS_BEGIN(STATS_READ);
+        uint64_t * codewords = read_compressed(input, &size, &width, &height,
+                                               &layout);
+        STATS_END(STATS_READ);
+
+        if (output_i420) {
+                unpack_i420(codewords, width, height, layout);
+                return;
+        }
+
+        STATS_BEGIN(STATS_QUANTIZE);
+        float * ypbpr = unpackPixels(codewords, width, height, layout);
+        STATS_END(STATS_QUANTIZE);
+
+        STATS_BEGIN(STATS_COLOR);
         PPMData ppmdata = ypbpr_to_rgb(ypbpr, width, height, PPM_max_value());
+        STATS_END(STATS_COLOR);
 
+        STATS_BEGIN(STATS_WRITE);
         print_ppm(ppmdata, width, height, PPM_max_value());
-}
\ No newline at end of file
+        STATS_END(STATS_WRITE);
+}
+
+/*
+******************************  HELPER FUNCTIONS **************************
+*/
+
+/*
+ * name:      pack_ppm
+ * purpose:   Reads a PPM image, converts it to YPbPr and packs it into
+ *            codewords.
+ * arguments: FILE *input - the input file pointer to the PPM image
+ *            int *width, int *height - pointers to store the trimmed size
+ * returns:   uint64_t* - one codeword per 2x2 block
+ * Author: Alijah Jackson
+ */
+static uint64_t *pack_ppm(FILE *input, int *width, int *height) {
+        size_t size = 0;
+        int maxVal;
+
+        STATS_BEGIN(STATS_READ);
+        PPMData ppmdata = read_ppm(input, &size, &maxVal, width, height);
+        STATS_END(STATS_READ);
+
+        STATS_BEGIN(STATS_COLOR);
+        float* chromaValues = rgb_to_ypbpr(ppmdata, *width, *height, maxVal);
+        STATS_END(STATS_COLOR);
+
+        STATS_BEGIN(STATS_QUANTIZE);
+        uint64_t* codewords = packPixels(chromaValues, *width, *height,
+                                         output_layout);
+        STATS_END(STATS_QUANTIZE);
+        return codewords;
+}
+
+/*
+ * name:      pack_i420
+ * purpose:   Reads a raw I420 image and packs it into codewords directly,
+ *            with no color conversion or chroma averaging.
+ * arguments: FILE *input - the input file pointer to the raw image
+ *            int *width, int *height - pointers to store the trimmed size
+ * returns:   uint64_t* - one codeword per 2x2 block
+ * Author: Alijah Jackson
+ */
+static uint64_t *pack_i420(FILE *input, int *width, int *height) {
+        STATS_BEGIN(STATS_READ);
+        Planar image = read_i420(input, input_i420_width, input_i420_height);
+        STATS_END(STATS_READ);
+
+        *width = image.width;
+        *height = image.height;
+
+        STATS_BEGIN(STATS_QUANTIZE);
+        uint64_t* codewords = packPlanar(image.y, image.pb, image.pr,
+                                         image.width, image.height,
+                                         output_layout);
+        STATS_END(STATS_QUANTIZE);
+
+        free_planar(&image);
+        return codewords;
+}
+
+/*
+ * name:      unpack_i420
+ * purpose:   Unpacks codewords straight to planar I420 and prints it.
+ * arguments: const uint64_t *codewords - one codeword per 2x2 block
+ *            int width, int height - dimensions of the image
+ *            const Layout *layout - codeword layout of the data
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void unpack_i420(const uint64_t *codewords, int width, int height,
+                        const Layout *layout) {
+        Planar image = new_planar(width, height);
+
+        STATS_BEGIN(STATS_QUANTIZE);
+        unpackPlanar(codewords, width, height, image.y, image.pb, image.pr,
+                     layout);
+        STATS_END(STATS_QUANTIZE);
+
+        STATS_BEGIN(STATS_WRITE);
+        print_i420(&image);
+        STATS_END(STATS_WRITE);
+
+        free_planar(&image);
+}
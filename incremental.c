@@ -0,0 +1,409 @@
+/* incremental.c
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the incremental re-encoder, which patches an existing
+ * compressed file in place with only the 2x2 blocks that differ between
+ * the previous and the new version of an image.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <reader.h>
+#include <transforms.h>
+#include <quan.h>
+#include <segment.h>
+#include <stats.h>
+#include <codec40.h>
+
+typedef struct Target {
+        const Layout *layout;
+        int width, height;
+        long payload_offset;    /* file offset of the first codeword */
+        int segment_count;      /* 0 for the plain format */
+        long table_offset;      /* file offset of the segment table */
+        char info[SEGMENT_INFO_SIZE];   /* header line the table covers */
+        Segment *segments;
+} Target;
+
+static const char *previous_ppm = NULL;
+static const char *compressed_path = NULL;
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static Target read_target(FILE *fp);
+static int block_changed(PPMData old_data, PPMData new_data, int width,
+                         int block_row, int block_col);
+static uint64_t encode_block(PPMData data, int width, int maxVal,
+                             int block_row, int block_col,
+                             const Layout *layout);
+static void write_run(int fd, long offset, const uint64_t *run, int length);
+static void verify_segments(int fd, const Target *target,
+                            const int *touched);
+static void update_checksums(int fd, const Target *target,
+                             const int *touched);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      recompress40_files
+ * purpose:   Names the previous PPM and the compressed file it was
+ *            encoded into, for recompress40 to patch.
+ * arguments: const char *old_ppm - path of the previous PPM image
+ *            const char *compressed - path of its compressed file
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void recompress40_files(const char *old_ppm, const char *compressed) {
+        previous_ppm = old_ppm;
+        compressed_path = compressed;
+}
+
+/*
+ * name:      recompress40
+ * purpose:   Re-encodes an edited image incrementally. The new image is
+ *            compared with the previous one 2x2 block at a time; only the
+ *            blocks that changed are transformed and quantized, and their
+ *            codewords are written over the old ones in the compressed
+ *            file with pwrite. In a segmented file every segment that
+ *            will be touched is first checked against its stored CRC32C,
+ *            and nothing is written if one fails, so a patch never hides
+ *            existing corruption behind a fresh checksum. The touched
+ *            segments and the segment table then get new checksums.
+ * arguments: FILE *input - the input file pointer to the new PPM image.
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void recompress40(FILE *input) {
+        size_t size = 0;
+        int width, height, maxVal;
+        int old_width, old_height, old_maxVal;
+
+        assert(previous_ppm != NULL && compressed_path != NULL);
+        FILE *old_fp = fopen(previous_ppm, "rb");
+        FILE *target_fp = fopen(compressed_path, "r+b");
+        assert(old_fp != NULL && target_fp != NULL);
+
+        STATS_BEGIN(STATS_READ);
+        PPMData new_data = read_ppm(input, &size, &maxVal, &width, &height);
+        PPMData old_data = read_ppm(old_fp, &size, &old_maxVal, &old_width,
+                                    &old_height);
+        Target target = read_target(target_fp);
+        STATS_END(STATS_READ);
+        fclose(old_fp);
+
+        if (width != old_width || height != old_height ||
+            width != target.width || height != target.height) {
+                fprintf(stderr, "Image sizes differ, compress the new "
+                        "image in full instead\n");
+                exit(EXIT_FAILURE);
+        }
+
+        int fd = fileno(target_fp);
+        int block_width = width / 2;
+        int block_rows = height / 2;
+        int all_changed = (maxVal != old_maxVal);
+        uint64_t *run = malloc(block_width * sizeof(uint64_t) + 1);
+        int *row_changed = calloc(block_rows + 1, sizeof(int));
+        int *touched = calloc(target.segment_count + 1, sizeof(int));
+        assert(run != NULL && row_changed != NULL && touched != NULL);
+
+        /* Segments tile the rows in order (see Segment_covers) */
+        STATS_BEGIN(STATS_QUANTIZE);
+        int segment = 0;
+        for (int block_row = 0; block_row < block_rows; block_row++) {
+                for (int block_col = 0;
+                     block_col < block_width && !row_changed[block_row];
+                     block_col++) {
+                        row_changed[block_row] = all_changed ||
+                                block_changed(old_data, new_data, width,
+                                              block_row, block_col);
+                }
+                if (target.segment_count == 0) {
+                        continue;
+                }
+                const Segment *current = &target.segments[segment];
+                if ((uint32_t)block_row >= current->first_row +
+                                           current->rows) {
+                        segment++;
+                }
+                touched[segment] |= row_changed[block_row];
+        }
+        STATS_END(STATS_QUANTIZE);
+
+        STATS_BEGIN(STATS_READ);
+        verify_segments(fd, &target, touched);
+        STATS_END(STATS_READ);
+
+        STATS_BEGIN(STATS_QUANTIZE);
+        for (int block_row = 0; block_row < block_rows; block_row++) {
+                if (!row_changed[block_row]) {
+                        continue;
+                }
+                int length = 0;
+                long run_offset = 0;
+                for (int block_col = 0; block_col <= block_width;
+                     block_col++) {
+                        int changed = block_col < block_width &&
+                                (all_changed ||
+                                 block_changed(old_data, new_data, width,
+                                               block_row, block_col));
+                        if (changed) {
+                                if (length == 0) {
+                                        run_offset = target.payload_offset +
+                                                ((long)block_row *
+                                                 block_width + block_col) *
+                                                (long)sizeof(uint64_t);
+                                }
+                                run[length++] = encode_block(new_data, width,
+                                                             maxVal,
+                                                             block_row,
+                                                             block_col,
+                                                             target.layout);
+                        } else if (length > 0) {
+                                write_run(fd, run_offset, run, length);
+                                length = 0;
+                        }
+                }
+        }
+        STATS_END(STATS_QUANTIZE);
+
+        STATS_BEGIN(STATS_WRITE);
+        if (target.segment_count > 0) {
+                update_checksums(fd, &target, touched);
+        }
+        STATS_END(STATS_WRITE);
+
+        fclose(target_fp);
+        free(touched);
+        free(row_changed);
+        free(run);
+        free(target.segments);
+        free_image(new_data);
+        free_image(old_data);
+}
+
+/*
+************************  HELPER FUNCTIONS ****************************
+*/
+
+/*
+ * name:      read_target
+ * purpose:   Reads the header of a compressed file (plain or segmented)
+ *            and works out where its codewords and segment table live.
+ * arguments: FILE *fp - file pointer to the compressed file
+ * returns:   Target - layout, size and file offsets of the codewords
+ * Author: Alijah Jackson
+ */
+static Target read_target(FILE *fp) {
+        Target target;
+        char header[64];
+        memset(&target, 0, sizeof(target));
+
+        assert(fgets(header, sizeof(header), fp) != NULL);
+        header[strcspn(header, "\n")] = '\0';
+
+        if (strcmp(header, SEGMENTED_HEADER) == 0) {
+                if (!Segment_read_info(fp, target.info, &target.layout,
+                                       &target.width, &target.height,
+                                       &target.segment_count)) {
+                        fprintf(stderr, "Segment header is corrupt\n");
+                        exit(EXIT_FAILURE);
+                }
+
+                int count = target.segment_count;
+                target.segments = malloc(count * sizeof(Segment) + 1);
+                assert(target.segments != NULL);
+                target.table_offset = ftell(fp);
+                if (!Segment_read_table(fp, target.info, target.segments,
+                                        count)) {
+                        fprintf(stderr, "Segment table is corrupt\n");
+                        exit(EXIT_FAILURE);
+                }
+                if (!Segment_covers(target.segments, count, target.width,
+                                    target.height)) {
+                        fprintf(stderr, "Segment table does not cover the "
+                                "image\n");
+                        exit(EXIT_FAILURE);
+                }
+                target.payload_offset = ftell(fp);
+        } else {
+                target.layout = Layout_by_header(header);
+                assert(target.layout != NULL);
+                assert(fscanf(fp, "%d %d", &target.width,
+                              &target.height) == 2);
+                int c;
+                while ((c = fgetc(fp)) != EOF && c != '\n');
+                target.payload_offset = ftell(fp);
+        }
+        return target;
+}
+
+/*
+ * name:      block_changed
+ * purpose:   Checks whether a 2x2 block differs between two images
+ * arguments: PPMData old_data, PPMData new_data - the two images
+ *            int width - width of both images
+ *            int block_row, int block_col - position of the block
+ * returns:   int - nonzero if any of the block's bytes differ
+ * Author: Alijah Jackson
+ */
+static int block_changed(PPMData old_data, PPMData new_data, int width,
+                         int block_row, int block_col) {
+        size_t top = ((size_t)block_row * 2 * width + block_col * 2) * 3;
+        size_t bottom = top + (size_t)width * 3;
+        return memcmp(old_data + top, new_data + top, 6) != 0 ||
+               memcmp(old_data + bottom, new_data + bottom, 6) != 0;
+}
+
+/*
+ * name:      encode_block
+ * purpose:   Runs the color transform and quantization on a single 2x2
+ *            block of an RGB image
+ * arguments: PPMData data - the image
+ *            int width - width of the image
+ *            int maxVal - maximum pixel value of the image
+ *            int block_row, int block_col - position of the block
+ *            const Layout *layout - codeword layout to pack into
+ * returns:   uint64_t - the block's codeword
+ * Author: Alijah Jackson
+ */
+static uint64_t encode_block(PPMData data, int width, int maxVal,
+                             int block_row, int block_col,
+                             const Layout *layout) {
+        unsigned char rgb[12];
+        size_t top = ((size_t)block_row * 2 * width + block_col * 2) * 3;
+        memcpy(rgb, data + top, 6);
+        memcpy(rgb + 6, data + top + (size_t)width * 3, 6);
+
+        float *ypbpr = rgb_to_ypbpr(rgb, 2, 2, maxVal);
+        uint64_t *codeword = packPixels(ypbpr, 2, 2, layout);
+        uint64_t result = codeword[0];
+
+        free(codeword);
+        free(ypbpr);
+        return result;
+}
+
+/*
+ * name:      write_run
+ * purpose:   Writes a run of adjacent codewords over the old ones with a
+ *            single pwrite
+ * arguments: int fd - descriptor of the compressed file
+ *            long offset - file offset of the first codeword in the run
+ *            const uint64_t *run - the codewords
+ *            int length - number of codewords
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void write_run(int fd, long offset, const uint64_t *run, int length) {
+        size_t bytes = (size_t)length * sizeof(uint64_t);
+        unsigned char *buffer = malloc(bytes);
+        assert(buffer != NULL);
+
+        for (int i = 0; i < length; i++) {
+                for (int byte = 0; byte < 8; byte++) {
+                        buffer[i * 8 + byte] = (run[i] >> (56 - 8 * byte))
+                                               & 0xFF;
+                }
+        }
+        ssize_t written = pwrite(fd, buffer, bytes, offset);
+        assert(written == (ssize_t)bytes);
+        STATS_BYTES_WRITTEN(bytes);
+        free(buffer);
+}
+
+/*
+ * name:      verify_segments
+ * purpose:   Checks every segment about to be patched against the CRC32C
+ *            in its table entry, and exits without writing anything if
+ *            one fails, naming the segment the way decompression would
+ * arguments: int fd - descriptor of the compressed file
+ *            const Target *target - layout of the compressed file
+ *            const int *touched - nonzero for each segment that changes
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void verify_segments(int fd, const Target *target,
+                            const int *touched) {
+        int failures = 0;
+        long offset = target->payload_offset;
+        for (int s = 0; s < target->segment_count; s++) {
+                const Segment *segment = &target->segments[s];
+                if (touched[s]) {
+                        unsigned char *payload = malloc(segment->length + 1);
+                        assert(payload != NULL);
+                        ssize_t read_count = pread(fd, payload,
+                                                   segment->length, offset);
+                        STATS_BYTES_READ(read_count > 0 ? read_count : 0);
+                        if (read_count != (ssize_t)segment->length ||
+                            crc32c(0, payload, segment->length) !=
+                            segment->crc) {
+                                fprintf(stderr, "Segment %d (block rows "
+                                        "%u-%u) failed its checksum\n", s,
+                                        segment->first_row,
+                                        segment->first_row + segment->rows
+                                        - 1);
+                                failures++;
+                        }
+                        free(payload);
+                }
+                offset += segment->length;
+        }
+        if (failures > 0) {
+                fprintf(stderr, "Not patching a corrupt file, compress the "
+                        "new image in full instead\n");
+                exit(EXIT_FAILURE);
+        }
+}
+
+/*
+ * name:      update_checksums
+ * purpose:   Recomputes the CRC32C of every touched segment from the
+ *            patched file and rewrites it, then rewrites the table's own
+ *            checksum
+ * arguments: int fd - descriptor of the compressed file
+ *            const Target *target - layout of the compressed file
+ *            const int *touched - nonzero for each segment that changed
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void update_checksums(int fd, const Target *target,
+                             const int *touched) {
+        size_t table_size = target->segment_count * SEGMENT_ENTRY_SIZE + 4;
+        unsigned char *table = malloc(table_size);
+        assert(table != NULL);
+
+        long offset = target->payload_offset;
+        for (int s = 0; s < target->segment_count; s++) {
+                Segment *segment = &target->segments[s];
+                if (touched[s]) {
+                        unsigned char *payload = malloc(segment->length + 1);
+                        assert(payload != NULL);
+                        ssize_t read_count = pread(fd, payload,
+                                                   segment->length, offset);
+                        assert(read_count == (ssize_t)segment->length);
+                        segment->crc = crc32c(0, payload, segment->length);
+                        free(payload);
+                }
+                offset += segment->length;
+        }
+        Segment_write_table(target->info, target->segments,
+                            target->segment_count, table);
+
+        ssize_t written = pwrite(fd, table, table_size, target->table_offset);
+        assert(written == (ssize_t)table_size);
+        STATS_BYTES_WRITTEN(table_size);
+        free(table);
+}
@@ -0,0 +1,62 @@
+/* layout.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the table of codeword layouts. Each layout gets its
+ * own specialized pack/unpack kernels generated in quan.c, and is chosen
+ * per file by the first line of the compressed header.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+
+/*
+ * One entry per layout:
+ *   X(id, name, header,
+ *     a_width, a_lsb, bcd_width, b_lsb, c_lsb, d_lsb,
+ *     chroma_width, pb_lsb, pr_lsb)
+ * A chroma width of 4 uses the Arith40 chroma table, which keeps format2
+ * byte-compatible; wider chroma fields are quantized linearly.
+ */
+#define CODEWORD_LAYOUTS(X) \
+        X(format2, "format2", "COMP40 Compressed image format 2", \
+          9, 23, 5, 18, 13, 8, 4, 4, 0) \
+        X(hq64, "hq64", "COMP40 Compressed image format 2 hq64", \
+          10, 37, 7, 30, 23, 16, 8, 8, 0)
+
+/* Quantized fields of one 2x2 block */
+typedef struct Quantized {
+        unsigned a;
+        int b, c, d;
+        unsigned pb, pr;
+} Quantized;
+
+typedef struct Layout {
+        const char *name;
+        const char *header;
+        unsigned a_width, a_lsb;
+        unsigned bcd_width, b_lsb, c_lsb, d_lsb;
+        unsigned chroma_width, pb_lsb, pr_lsb;
+        uint64_t *(*pack)(const float *ypbpr, int width, int height);
+        float *(*unpack)(const uint64_t *codewords, int width, int height);
+        uint64_t *(*pack_planar)(const unsigned char *y,
+                                 const unsigned char *pb,
+                                 const unsigned char *pr,
+                                 int width, int height);
+        void (*unpack_planar)(const uint64_t *codewords, int width,
+                              int height, unsigned char *y,
+                              unsigned char *pb, unsigned char *pr);
+} Layout;
+
+#define X(id, ...) LAYOUT_##id,
+enum { CODEWORD_LAYOUTS(X) NUM_LAYOUTS };
+#undef X
+
+extern const Layout LAYOUTS[NUM_LAYOUTS];
+
+const Layout *Layout_by_name(const char *name);
+const Layout *Layout_by_header(const char *header);
+
+#endif
@@ -0,0 +1,133 @@
+/* planar.c
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains functions for reading and writing raw 8-bit planar
+ * Y/Pb/Pr images with 2x2 subsampled chroma (I420 plane order).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <planar.h>
+#include <stats.h>
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static void read_plane(FILE *fp, unsigned char *dest, int width,
+                       int height, int stride, int rows);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      new_planar
+ * purpose:   Allocates a planar image with 2x2 subsampled chroma.
+ * arguments: int width - width of the Y plane (even)
+ *            int height - height of the Y plane (even)
+ * returns:   Planar - the image, with uninitialized planes
+ * Author: Alijah Jackson
+ */
+Planar new_planar(int width, int height) {
+        Planar image;
+        size_t chroma_size = (size_t)(width / 2) * (height / 2);
+
+        image.width = width;
+        image.height = height;
+        image.y = malloc((size_t)width * height + 1);
+        image.pb = malloc(chroma_size + 1);
+        image.pr = malloc(chroma_size + 1);
+        assert(image.y != NULL && image.pb != NULL && image.pr != NULL);
+        return image;
+}
+
+/*
+ * name:      read_i420
+ * purpose:   Reads a raw I420 image: the Y plane followed by the Pb and Pr
+ *            planes at half resolution, rounded up for odd sizes. Like
+ *            read_ppm, the image is trimmed to even dimensions.
+ * arguments: FILE *fp - file pointer to the raw image
+ *            int width - width of the Y plane
+ *            int height - height of the Y plane
+ * returns:   Planar - the trimmed image
+ * Author: Alijah Jackson
+ */
+Planar read_i420(FILE *fp, int width, int height) {
+        int chroma_width = (width + 1) / 2;
+        int chroma_height = (height + 1) / 2;
+        Planar image = new_planar(width - width % 2, height - height % 2);
+
+        read_plane(fp, image.y, image.width, image.height, width, height);
+        read_plane(fp, image.pb, image.width / 2, image.height / 2,
+                   chroma_width, chroma_height);
+        read_plane(fp, image.pr, image.width / 2, image.height / 2,
+                   chroma_width, chroma_height);
+        return image;
+}
+
+/*
+ * name:      print_i420
+ * purpose:   Prints a planar image to stdout as raw I420.
+ * arguments: const Planar *image - the image to print
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void print_i420(const Planar *image) {
+        size_t luma_size = (size_t)image->width * image->height;
+        size_t chroma_size = luma_size / 4;
+
+        fwrite(image->y, 1, luma_size, stdout);
+        fwrite(image->pb, 1, chroma_size, stdout);
+        fwrite(image->pr, 1, chroma_size, stdout);
+        STATS_BYTES_WRITTEN(luma_size + 2 * chroma_size);
+}
+
+/*
+ * name:      free_planar
+ * purpose:   Frees the planes of a planar image.
+ * arguments: Planar *image - the image to free
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void free_planar(Planar *image) {
+        free(image->y);
+        free(image->pb);
+        free(image->pr);
+        image->y = image->pb = image->pr = NULL;
+}
+
+/*
+************************  HELPER FUNCTIONS ****************************
+*/
+
+/*
+ * name:      read_plane
+ * purpose:   Reads one plane of stride x rows bytes, keeping only the
+ *            top-left width x height of it.
+ * arguments: FILE *fp - file pointer to the raw image
+ *            unsigned char *dest - where to store the kept bytes
+ *            int width, int height - size to keep
+ *            int stride, int rows - size of the plane in the file
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void read_plane(FILE *fp, unsigned char *dest, int width,
+                       int height, int stride, int rows) {
+        unsigned char *line = malloc(stride + 1);
+        assert(line != NULL);
+
+        for (int row = 0; row < rows; row++) {
+                size_t read_count = fread(line, 1, stride, fp);
+                assert(read_count == (size_t)stride);
+                if (row < height) {
+                        memcpy(dest + (size_t)row * width, line, width);
+                }
+        }
+        STATS_BYTES_READ((size_t)stride * rows);
+        free(line);
+}
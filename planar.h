@@ -0,0 +1,26 @@
+/* planar.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains declarations for reading and writing raw 8-bit
+ * planar Y/Pb/Pr images with 2x2 subsampled chroma (I420 plane order).
+ */
+
+#ifndef PLANAR_H
+#define PLANAR_H
+
+#include <stdio.h>
+
+typedef struct Planar {
+        int width, height;
+        unsigned char *y;       /* width x height */
+        unsigned char *pb;      /* (width / 2) x (height / 2) */
+        unsigned char *pr;      /* (width / 2) x (height / 2) */
+} Planar;
+
+Planar new_planar(int width, int height);
+Planar read_i420(FILE *fp, int width, int height);
+void print_i420(const Planar *image);
+void free_planar(Planar *image);
+
+#endif
@@ -3,20 +3,40 @@
 #include <string.h>
 
 #include <arith40.h>
-#include <bitpack.h> 
+#include <bitpackv.h>
 #include <transforms.h>
+#include <layout.h>
+#include <stats.h>
 
 #define DEFAULT_SIZE 2
+#define BCD_RANGE 0.3f
+#define NUM_FIELDS 6
 
 /*
 ******************************  PROTOTYPE FUNCTIONS ************************
 */
 
 float* chromaBlockAverages(float block[][3]);
-uint64_t constructCodeword(unsigned a_quantized, int b_quantized, 
-                           int c_quantized, int d_quantized, 
-                           unsigned pb_index, unsigned pr_index);
-float* deconstructCodeword(uint64_t codeword);
+
+#define X(id, ...) \
+    static uint64_t* pack_##id(const float *ycbcr, int width, int height); \
+    static float* unpack_##id(const uint64_t *codewords, int width, \
+                              int height); \
+    static uint64_t* pack_planar_##id(const unsigned char *y, \
+                                      const unsigned char *pb, \
+                                      const unsigned char *pr, \
+                                      int width, int height); \
+    static void unpack_planar_##id(const uint64_t *codewords, int width, \
+                                   int height, unsigned char *y, \
+                                   unsigned char *pb, unsigned char *pr);
+CODEWORD_LAYOUTS(X)
+#undef X
+
+#define X(id, name, header, AW, AL, BW, BL, CL, DL, CW, PBL, PRL) \
+    { name, header, AW, AL, BW, BL, CL, DL, CW, PBL, PRL, \
+      pack_##id, unpack_##id, pack_planar_##id, unpack_planar_##id },
+const Layout LAYOUTS[NUM_LAYOUTS] = { CODEWORD_LAYOUTS(X) };
+#undef X
 
 /*
 ******************************  MAIN FUNCTIONS ************************
@@ -24,23 +44,276 @@ float* deconstructCodeword(uint64_t codeword);
 
 /*
  * name:      packPixels
- * purpose:   Packs pixel values into a 64-bit codeword.
- *            This function takes individual pixel components and combines
- *            them into a single 64-bit codeword using bit manipulation
- *            techniques. The packed codeword can be used for efficient
- *            storage and transmission of pixel data.
- * arguments: float y, float pb, float pr - The Y, Pb, and Pr components
- *                                          of the pixel to be packed.
- * returns:   uint64_t - The packed 64-bit codeword containing the pixel
- *                       data.
- * Author: Alijah Jackson
- */
-uint64_t* packPixels(const float *ycbcr, int width, int height) {
+ * purpose:   Packs pixel values into 64-bit codewords.
+ *            Each 2x2 block of YPbPr pixels is transformed, quantized and
+ *            packed into one codeword by the kernel generated for the
+ *            given layout.
+ * arguments: const float *ycbcr - YPbPr image data
+ *            int width, int height - dimensions of the image
+ *            const Layout *layout - codeword layout to pack into
+ * returns:   uint64_t* - one codeword per 2x2 block
+ * Author: Alijah Jackson
+ */
+uint64_t* packPixels(const float *ycbcr, int width, int height,
+                     const Layout *layout) {
+    return layout->pack(ycbcr, width, height);
+}
+
+/*
+ * name:      unpackPixels
+ * purpose:   Unpacks pixel values from 64-bit codewords.
+ *            Each codeword is unpacked and dequantized by the kernel
+ *            generated for the given layout and expanded back into a 2x2
+ *            block of YPbPr pixels.
+ * arguments: const uint64_t *codewords - one codeword per 2x2 block
+ *            int width, int height - dimensions of the image
+ *            const Layout *layout - codeword layout to unpack from
+ * returns:   float* - YPbPr image data
+ * Author: Alijah Jackson
+ */
+float* unpackPixels(const uint64_t* codewords, int width, int height,
+                    const Layout *layout) {
+    return layout->unpack(codewords, width, height);
+}
+
+/*
+ * name:      packPlanar
+ * purpose:   Packs an 8-bit planar Y/Pb/Pr image with 2x2 subsampled
+ *            chroma (I420 order) into 64-bit codewords, without going
+ *            through RGB or averaging chroma.
+ * arguments: const unsigned char *y, *pb, *pr - the three planes
+ *            int width, int height - dimensions of the Y plane (even)
+ *            const Layout *layout - codeword layout to pack into
+ * returns:   uint64_t* - one codeword per 2x2 block
+ * Author: Alijah Jackson
+ */
+uint64_t* packPlanar(const unsigned char *y, const unsigned char *pb,
+                     const unsigned char *pr, int width, int height,
+                     const Layout *layout) {
+    return layout->pack_planar(y, pb, pr, width, height);
+}
+
+/*
+ * name:      unpackPlanar
+ * purpose:   Unpacks 64-bit codewords straight into an 8-bit planar
+ *            Y/Pb/Pr image with 2x2 subsampled chroma.
+ * arguments: const uint64_t *codewords - one codeword per 2x2 block
+ *            int width, int height - dimensions of the Y plane
+ *            unsigned char *y, *pb, *pr - the three planes to fill
+ *            const Layout *layout - codeword layout to unpack from
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void unpackPlanar(const uint64_t *codewords, int width, int height,
+                  unsigned char *y, unsigned char *pb, unsigned char *pr,
+                  const Layout *layout) {
+    layout->unpack_planar(codewords, width, height, y, pb, pr);
+}
+
+/*
+ * name:      Layout_by_name
+ * purpose:   Finds a codeword layout by its short name
+ * arguments: const char *name - layout name, e.g. "format2"
+ * returns:   const Layout* - the layout, or NULL if there is none
+ * Author: Alijah Jackson
+ */
+const Layout *Layout_by_name(const char *name) {
+    for (int i = 0; i < NUM_LAYOUTS; i++) {
+        if (strcmp(LAYOUTS[i].name, name) == 0) return &LAYOUTS[i];
+    }
+    return NULL;
+}
+
+/*
+ * name:      Layout_by_header
+ * purpose:   Finds a codeword layout by the first line of a compressed
+ *            file (without its newline)
+ * arguments: const char *header - header line
+ * returns:   const Layout* - the layout, or NULL if there is none
+ * Author: Alijah Jackson
+ */
+const Layout *Layout_by_header(const char *header) {
+    for (int i = 0; i < NUM_LAYOUTS; i++) {
+        if (strcmp(LAYOUTS[i].header, header) == 0) return &LAYOUTS[i];
+    }
+    return NULL;
+}
+
+/*
+******************************  KERNELS **************************
+*/
+
+/*
+ * The helpers below take the layout's widths and shifts as plain
+ * arguments. Every call site passes the literal constants from
+ * CODEWORD_LAYOUTS, so once inlined each layout gets its own
+ * straight-line shift-and-mask code with no range checks or branches.
+ */
+
+/*
+ * name:      quantizeChroma / dequantizeChroma
+ * purpose:   Map an average chroma value to and from its index
+ * arguments: float value / unsigned index - value or index to map
+ *            unsigned CW - chroma field width
+ * returns:   unsigned index / float value
+ * Author: Alijah Jackson
+ */
+static inline unsigned quantizeChroma(float value, unsigned CW) {
+    if (CW == 4) return Arith40_index_of_chroma(value);
+    return (unsigned)roundf((value + 0.5f) * (float)((1u << CW) - 1));
+}
+
+static inline float dequantizeChroma(unsigned index, unsigned CW) {
+    if (CW == 4) return Arith40_chroma_of_index(index);
+    return index / (float)((1u << CW) - 1) - 0.5f;
+}
+
+/*
+ * name:      quantizeLuma
+ * purpose:   Transforms and quantizes the four Y values of a 2x2 block
+ *            into the a, b, c and d fields
+ * arguments: float y_pixels[4] - the block's Y values
+ *            Quantized *q - fields to fill in
+ *            unsigned AW, BW - widths of a and b/c/d
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static inline void quantizeLuma(float y_pixels[4], Quantized *q,
+                                unsigned AW, unsigned BW) {
+    unsigned a_max = (1u << AW) - 1;
+    int bcd_max = (1 << (BW - 1)) - 1;
+
+    float* coefficients = pixelsToCoefficients(y_pixels);
+
+    unsigned a_raw = (unsigned)roundf(coefficients[0] * (float)a_max);
+    int b_raw = (int)roundf(coefficients[1] / BCD_RANGE * (float)bcd_max);
+    int c_raw = (int)roundf(coefficients[2] / BCD_RANGE * (float)bcd_max);
+    int d_raw = (int)roundf(coefficients[3] / BCD_RANGE * (float)bcd_max);
+    q->a = (a_raw > a_max) ? a_max : a_raw;
+    q->b = clamp(b_raw, -bcd_max, bcd_max);
+    q->c = clamp(c_raw, -bcd_max, bcd_max);
+    q->d = clamp(d_raw, -bcd_max, bcd_max);
+
+    STATS_SATURATE(STATS_A, q->a != a_raw);
+    STATS_SATURATE(STATS_B, q->b != b_raw);
+    STATS_SATURATE(STATS_C, q->c != c_raw);
+    STATS_SATURATE(STATS_D, q->d != d_raw);
+    STATS_HISTOGRAM(STATS_A, (int)q->a);
+    STATS_HISTOGRAM(STATS_B, q->b);
+    STATS_HISTOGRAM(STATS_C, q->c);
+    STATS_HISTOGRAM(STATS_D, q->d);
+
+    free(coefficients);
+}
+
+/*
+ * name:      quantizeBlock
+ * purpose:   Transforms and quantizes one 2x2 block of YPbPr pixels
+ * arguments: float block[4][3] - the block's pixels
+ *            unsigned AW, BW, CW - widths of a, b/c/d and chroma
+ * returns:   Quantized - the block's quantized fields
+ * Author: Alijah Jackson
+ */
+static inline Quantized quantizeBlock(float block[4][3], unsigned AW,
+                                      unsigned BW, unsigned CW) {
+    float* chroma_avg = chromaBlockAverages(block);
+
+    float y_pixels[4] = { block[0][0], block[1][0], block[2][0],
+                          block[3][0] };
+
+    Quantized q;
+    quantizeLuma(y_pixels, &q, AW, BW);
+    q.pb = quantizeChroma(chroma_avg[0], CW);
+    q.pr = quantizeChroma(chroma_avg[1], CW);
+    STATS_HISTOGRAM(STATS_PB, (int)q.pb);
+    STATS_HISTOGRAM(STATS_PR, (int)q.pr);
+
+    free(chroma_avg);
+    return q;
+}
+
+/*
+ * name:      packFields / unpackFields
+ * purpose:   Pack n codewords from one value array per field and back
+ *            again. The six fields are spelled out rather than looped
+ *            over a table, so each inline Bitpack loop sees a literal
+ *            width and lsb and the shifts and masks fold.
+ * arguments: uint64_t *codewords - the n codewords
+ *            size_t n - number of codewords
+ *            int32_t *values[NUM_FIELDS] - a, b, c, d, pb and pr arrays
+ *            the layout's widths and least significant bits
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static inline void packFields(uint64_t *codewords, size_t n,
+                              int32_t *values[NUM_FIELDS], unsigned AW,
+                              unsigned AL, unsigned BW, unsigned BL,
+                              unsigned CL, unsigned DL, unsigned CW,
+                              unsigned PBL, unsigned PRL) {
+    Bitpack_field a = { AW, AL, false }, b = { BW, BL, true },
+                  c = { BW, CL, true }, d = { BW, DL, true },
+                  pb = { CW, PBL, false }, pr = { CW, PRL, false };
+
+    Bitpack_checkv(a, values[0], n);
+    Bitpack_checkv(b, values[1], n);
+    Bitpack_checkv(c, values[2], n);
+    Bitpack_checkv(d, values[3], n);
+    Bitpack_checkv(pb, values[4], n);
+    Bitpack_checkv(pr, values[5], n);
+
+    memset(codewords, 0, n * sizeof(uint64_t));
+    Bitpack_packv_field(codewords, n, a, values[0]);
+    Bitpack_packv_field(codewords, n, b, values[1]);
+    Bitpack_packv_field(codewords, n, c, values[2]);
+    Bitpack_packv_field(codewords, n, d, values[3]);
+    Bitpack_packv_field(codewords, n, pb, values[4]);
+    Bitpack_packv_field(codewords, n, pr, values[5]);
+}
+
+static inline void unpackFields(const uint64_t *codewords, size_t n,
+                                int32_t *values[NUM_FIELDS], unsigned AW,
+                                unsigned AL, unsigned BW, unsigned BL,
+                                unsigned CL, unsigned DL, unsigned CW,
+                                unsigned PBL, unsigned PRL) {
+    Bitpack_unpackv_field(codewords, n, (Bitpack_field){ AW, AL, false },
+                          values[0]);
+    Bitpack_unpackv_field(codewords, n, (Bitpack_field){ BW, BL, true },
+                          values[1]);
+    Bitpack_unpackv_field(codewords, n, (Bitpack_field){ BW, CL, true },
+                          values[2]);
+    Bitpack_unpackv_field(codewords, n, (Bitpack_field){ BW, DL, true },
+                          values[3]);
+    Bitpack_unpackv_field(codewords, n, (Bitpack_field){ CW, PBL, false },
+                          values[4]);
+    Bitpack_unpackv_field(codewords, n, (Bitpack_field){ CW, PRL, false },
+                          values[5]);
+}
+
+/*
+ * name:      packLoop
+ * purpose:   Quantizes every 2x2 block of an image into one array per
+ *            field, then packs them all a field at a time
+ * arguments: const float *ycbcr - YPbPr image data
+ *            int width, int height - dimensions of the image
+ *            the layout's widths and least significant bits
+ * returns:   uint64_t* - one codeword per block
+ * Author: Alijah Jackson
+ */
+static inline uint64_t* packLoop(const float *ycbcr, int width, int height,
+                                 unsigned AW, unsigned AL, unsigned BW,
+                                 unsigned BL, unsigned CL, unsigned DL,
+                                 unsigned CW, unsigned PBL, unsigned PRL) {
     int block_width = width / 2;
     int block_number = (width * height) / 4;
     uint64_t *codewords = malloc(block_number * sizeof(uint64_t));
+    int32_t *quantized = malloc(NUM_FIELDS * block_number * sizeof(int32_t));
+    int32_t *values[NUM_FIELDS];
+    for (int f = 0; f < NUM_FIELDS; f++) {
+        values[f] = quantized + f * block_number;
+    }
 
     for (int block_idx = 0; block_idx < block_number; block_idx++) {
+        STATS_STRIPE(STATS_QUANTIZE, block_idx, block_width);
         int block_row = (block_idx / block_width) * 2;
         int block_col = (block_idx % block_width) * 2;
         int base_idx = (block_row * width + block_col) * 3;
@@ -55,53 +328,63 @@ uint64_t* packPixels(const float *ycbcr, int width, int height) {
             block[i][2] = ycbcr[data_idx + 2];
         }
 
-        float* chroma_avg = chromaBlockAverages(block);
-
-        float y_pixels[4] = { block[0][0], block[1][0], block[2][0], 
-                              block[3][0] };
-        float* coefficients = pixelsToCoefficients(y_pixels);
-
-        unsigned a = (unsigned)roundf(coefficients[0] * 511.0f);
-        a = (a > 511) ? 511 : a;
-        int b = clamp((int)roundf(coefficients[1] / 0.3f * 15.0f), -15, 15);
-        int c = clamp((int)roundf(coefficients[2] / 0.3f * 15.0f), -15, 15);
-        int d = clamp((int)roundf(coefficients[3] / 0.3f * 15.0f), -15, 15);
-        unsigned pb_index = Arith40_index_of_chroma(chroma_avg[0]);
-        unsigned pr_index = Arith40_index_of_chroma(chroma_avg[1]);
-    
-        codewords[block_idx] = constructCodeword(a, b, c, d, pb_index, 
-                                                 pr_index);
+        Quantized q = quantizeBlock(block, AW, BW, CW);
+        values[0][block_idx] = q.a;
+        values[1][block_idx] = q.b;
+        values[2][block_idx] = q.c;
+        values[3][block_idx] = q.d;
+        values[4][block_idx] = q.pb;
+        values[5][block_idx] = q.pr;
     }
+    STATS_STRIPE_DONE(STATS_QUANTIZE, height / 2);
+
+    packFields(codewords, block_number, values, AW, AL, BW, BL, CL, DL, CW,
+               PBL, PRL);
+
+    free(quantized);
     return codewords;
 }
 
 /*
- * name:      unpackPixels
- * purpose:   Unpacks pixel values from a 64-bit codeword.
- *            This function extracts individual pixel components from a
- *            64-bit codeword using bit manipulation techniques. The
- *            unpacked values are returned as an array of floating-point
- *            numbers.
- * arguments: uint64_t codeword - The 64-bit codeword containing the
- *                                packed pixel data.
- * returns:   float* - A dynamically allocated array of floating-point
- *                     values representing the unpacked pixel components.
- *                     The array contains three elements: Y, Pb, and Pr.
- * Author: Alijah Jackson
- */
-float* unpackPixels(uint64_t* codewords, int width, int height) {
+ * name:      unpackLoop
+ * purpose:   Unpacks every codeword of an image a field at a time,
+ *            then dequantizes each block
+ * arguments: const uint64_t *codewords - one codeword per 2x2 block
+ *            int width, int height - dimensions of the image
+ *            the layout's widths and least significant bits
+ * returns:   float* - YPbPr image data
+ * Author: Alijah Jackson
+ */
+static inline float* unpackLoop(const uint64_t *codewords, int width,
+                                int height, unsigned AW, unsigned AL,
+                                unsigned BW, unsigned BL, unsigned CL,
+                                unsigned DL, unsigned CW, unsigned PBL,
+                                unsigned PRL) {
     int numBlocks = (width * height) / 4;
     int size = width * height * 3;
+    float a_scale = (float)((1u << AW) - 1);
+    float bcd_scale = (float)((1 << (BW - 1)) - 1);
+
+    int32_t *quantized = malloc(NUM_FIELDS * numBlocks * sizeof(int32_t));
+    int32_t *values[NUM_FIELDS];
+    for (int f = 0; f < NUM_FIELDS; f++) {
+        values[f] = quantized + f * numBlocks;
+    }
+
+    unpackFields(codewords, numBlocks, values, AW, AL, BW, BL, CL, DL, CW,
+                 PBL, PRL);
 
     float* ypbpr = malloc(size * sizeof(float));
     for (int block_idx = 0; block_idx < numBlocks; block_idx++) {
-        float* qn = deconstructCodeword(codewords[block_idx]);
-
-        float coefs[4] = { qn[0], qn[1], qn[2], qn[3] };
+        STATS_STRIPE(STATS_QUANTIZE, block_idx, width / 2);
+        float coefs[4] = { values[0][block_idx] / a_scale,
+                           values[1][block_idx] * BCD_RANGE / bcd_scale,
+                           values[2][block_idx] * BCD_RANGE / bcd_scale,
+                           values[3][block_idx] * BCD_RANGE / bcd_scale };
         float* pixels = coefficientsToPixels(coefs);
 
-        float pb = qn[4];
-        float pr = qn[5];
+        float pb = dequantizeChroma(values[4][block_idx], CW);
+        float pr = dequantizeChroma(values[5][block_idx], CW);
 
         for (int i = 0; i < 4; i++) {
             int row = (block_idx / (width / 2)) * 2 + (i / 2);
@@ -113,56 +396,217 @@ float* unpackPixels(uint64_t* codewords, int width, int height) {
             ypbpr[base_idx + 2] = pr;
         }
 
-        free(qn);
         free(pixels);
     }
+    STATS_STRIPE_DONE(STATS_QUANTIZE, height / 2);
+
+    free(quantized);
     return ypbpr;
 }
 
+/*
+ * name:      packPlanarLoop
+ * purpose:   Quantizes and packs an 8-bit planar image with 2x2
+ *            subsampled chroma. Each chroma sample already is the block
+ *            average, so there is no color conversion or chroma
+ *            averaging.
+ * arguments: const unsigned char *y, *pb, *pr - the three planes
+ *            int width, int height - dimensions of the Y plane
+ *            the layout's widths and least significant bits
+ * returns:   uint64_t* - one codeword per block
+ * Author: Alijah Jackson
+ */
+static inline uint64_t* packPlanarLoop(const unsigned char *y,
+                                       const unsigned char *pb,
+                                       const unsigned char *pr, int width,
+                                       int height, unsigned AW, unsigned AL,
+                                       unsigned BW, unsigned BL, unsigned CL,
+                                       unsigned DL, unsigned CW, unsigned PBL,
+                                       unsigned PRL) {
+    int block_width = width / 2;
+    int block_number = (width * height) / 4;
+    uint64_t *codewords = malloc(block_number * sizeof(uint64_t));
+    int32_t *quantized = malloc(NUM_FIELDS * block_number * sizeof(int32_t));
+    int32_t *values[NUM_FIELDS];
+    for (int f = 0; f < NUM_FIELDS; f++) {
+        values[f] = quantized + f * block_number;
+    }
+
+    for (int block_idx = 0; block_idx < block_number; block_idx++) {
+        STATS_STRIPE(STATS_QUANTIZE, block_idx, block_width);
+        int base_idx = (block_idx / block_width) * 2 * width +
+                       (block_idx % block_width) * 2;
+
+        float y_pixels[4] = { y[base_idx] / 255.0f,
+                              y[base_idx + 1] / 255.0f,
+                              y[base_idx + width] / 255.0f,
+                              y[base_idx + width + 1] / 255.0f };
+        float pb_raw = (pb[block_idx] - 128) / 255.0f;
+        float pr_raw = (pr[block_idx] - 128) / 255.0f;
+        float pb_value = clamp(pb_raw, -0.5f, 0.5f);
+        float pr_value = clamp(pr_raw, -0.5f, 0.5f);
+        STATS_SATURATE(STATS_PB, pb_value != pb_raw);
+        STATS_SATURATE(STATS_PR, pr_value != pr_raw);
+
+        Quantized q;
+        quantizeLuma(y_pixels, &q, AW, BW);
+        q.pb = quantizeChroma(pb_value, CW);
+        q.pr = quantizeChroma(pr_value, CW);
+        STATS_HISTOGRAM(STATS_PB, (int)q.pb);
+        STATS_HISTOGRAM(STATS_PR, (int)q.pr);
+
+        values[0][block_idx] = q.a;
+        values[1][block_idx] = q.b;
+        values[2][block_idx] = q.c;
+        values[3][block_idx] = q.d;
+        values[4][block_idx] = q.pb;
+        values[5][block_idx] = q.pr;
+    }
+    STATS_STRIPE_DONE(STATS_QUANTIZE, height / 2);
+
+    packFields(codewords, block_number, values, AW, AL, BW, BL, CL, DL, CW,
+               PBL, PRL);
+
+    free(quantized);
+    return codewords;
+}
+
+/*
+ * name:      unpackPlanarLoop
+ * purpose:   Unpacks and dequantizes every codeword straight into an
+ *            8-bit planar image with 2x2 subsampled chroma, skipping the
+ *            conversion back to RGB
+ * arguments: const uint64_t *codewords - one codeword per 2x2 block
+ *            int width, int height - dimensions of the Y plane
+ *            unsigned char *y, *pb, *pr - the three planes to fill
+ *            the layout's widths and least significant bits
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static inline void unpackPlanarLoop(const uint64_t *codewords, int width,
+                                    int height, unsigned char *y,
+                                    unsigned char *pb, unsigned char *pr,
+                                    unsigned AW, unsigned AL, unsigned BW,
+                                    unsigned BL, unsigned CL, unsigned DL,
+                                    unsigned CW, unsigned PBL,
+                                    unsigned PRL) {
+    int block_width = width / 2;
+    int numBlocks = (width * height) / 4;
+    float a_scale = (float)((1u << AW) - 1);
+    float bcd_scale = (float)((1 << (BW - 1)) - 1);
+
+    int32_t *quantized = malloc(NUM_FIELDS * numBlocks * sizeof(int32_t));
+    int32_t *values[NUM_FIELDS];
+    for (int f = 0; f < NUM_FIELDS; f++) {
+        values[f] = quantized + f * numBlocks;
+    }
+
+    unpackFields(codewords, numBlocks, values, AW, AL, BW, BL, CL, DL, CW,
+                 PBL, PRL);
+
+    for (int block_idx = 0; block_idx < numBlocks; block_idx++) {
+        STATS_STRIPE(STATS_QUANTIZE, block_idx, block_width);
+        float coefs[4] = { values[0][block_idx] / a_scale,
+                           values[1][block_idx] * BCD_RANGE / bcd_scale,
+                           values[2][block_idx] * BCD_RANGE / bcd_scale,
+                           values[3][block_idx] * BCD_RANGE / bcd_scale };
+        float* pixels = coefficientsToPixels(coefs);
+
+        int base_idx = (block_idx / block_width) * 2 * width +
+                       (block_idx % block_width) * 2;
+        for (int i = 0; i < 4; i++) {
+            y[base_idx + (i / 2) * width + (i % 2)] =
+                (unsigned char)roundf(clamp(pixels[i], 0, 1) * 255.0f);
+        }
+
+        float pb_value = dequantizeChroma(values[4][block_idx], CW);
+        float pr_value = dequantizeChroma(values[5][block_idx], CW);
+        pb[block_idx] = (unsigned char)roundf(clamp(pb_value * 255.0f + 128,
+                                                    0, 255));
+        pr[block_idx] = (unsigned char)roundf(clamp(pr_value * 255.0f + 128,
+                                                    0, 255));
+
+        free(pixels);
+    }
+    STATS_STRIPE_DONE(STATS_QUANTIZE, height / 2);
+
+    free(quantized);
+}
+
+/* One set of kernels per entry in CODEWORD_LAYOUTS */
+#define X(id, name, header, AW, AL, BW, BL, CL, DL, CW, PBL, PRL) \
+    static uint64_t* pack_##id(const float *ycbcr, int width, int height) { \
+        return packLoop(ycbcr, width, height, AW, AL, BW, BL, CL, DL, \
+                        CW, PBL, PRL); \
+    } \
+    static float* unpack_##id(const uint64_t *codewords, int width, \
+                              int height) { \
+        return unpackLoop(codewords, width, height, AW, AL, BW, BL, CL, \
+                          DL, CW, PBL, PRL); \
+    } \
+    static uint64_t* pack_planar_##id(const unsigned char *y, \
+                                      const unsigned char *pb, \
+                                      const unsigned char *pr, \
+                                      int width, int height) { \
+        return packPlanarLoop(y, pb, pr, width, height, AW, AL, BW, BL, \
+                              CL, DL, CW, PBL, PRL); \
+    } \
+    static void unpack_planar_##id(const uint64_t *codewords, int width, \
+                                   int height, unsigned char *y, \
+                                   unsigned char *pb, unsigned char *pr) { \
+        unpackPlanarLoop(codewords, width, height, y, pb, pr, AW, AL, BW, \
+                         BL, CL, DL, CW, PBL, PRL); \
+    }
+CODEWORD_LAYOUTS(X)
+#undef X
+
 /*
 ******************************  HELPER FUNCTIONS **************************
 */
 
 /*
- * name:      constructCodeword
- * purpose:   Constructs a codeword from quantized values
- * arguments: quantized values of a,b,c,d and the pb and pr indices
- * returns:   uint64_t - constructed codeword
+ * name:      layoutFields
+ * purpose:   Describes a layout's six fields (a, b, c, d, pb, pr) for the
+ *            bulk Bitpack calls
+ * arguments: const Layout *layout - codeword layout
+ *            Bitpack_field fields[6] - table to fill in
+ * returns:   void
  * Author: Alijah Jackson
  */
-uint64_t constructCodeword(unsigned a_quantized, int b_quantized, 
-                           int c_quantized, int d_quantized, 
-                           unsigned pb_index, unsigned pr_index) {
-    uint64_t codeword = 0;
-    codeword = Bitpack_newu(codeword, 9, 23, a_quantized);
-    codeword = Bitpack_news(codeword, 5, 18, b_quantized);
-    codeword = Bitpack_news(codeword, 5, 13, c_quantized);
-    codeword = Bitpack_news(codeword, 5, 8, d_quantized);
-    codeword = Bitpack_newu(codeword, 4, 4, pb_index);
-    codeword = Bitpack_newu(codeword, 4, 0, pr_index);
-    return codeword;
+void layoutFields(const Layout *layout, Bitpack_field fields[NUM_FIELDS]) {
+    fields[0] = (Bitpack_field){ layout->a_width, layout->a_lsb, false };
+    fields[1] = (Bitpack_field){ layout->bcd_width, layout->b_lsb, true };
+    fields[2] = (Bitpack_field){ layout->bcd_width, layout->c_lsb, true };
+    fields[3] = (Bitpack_field){ layout->bcd_width, layout->d_lsb, true };
+    fields[4] = (Bitpack_field){ layout->chroma_width, layout->pb_lsb,
+                                 false };
+    fields[5] = (Bitpack_field){ layout->chroma_width, layout->pr_lsb,
+                                 false };
 }
 
 /*
- * name:      deconstructCodeword
- * purpose:   Deconstructs a codeword into quantized values
- * arguments: uint64_t codeword - codeword to be deconstructed
- * returns:   float* - array of deconstructed values
+ * name:      dequantizeTables
+ * purpose:   Fills lookup tables from quantized a and chroma indices to
+ *            their values, so a scan over many codewords needs no per-
+ *            field arithmetic or Arith40 calls
+ * arguments: const Layout *layout - codeword layout
+ *            float *a_table - 2^a_width entries to fill, or NULL
+ *            float *chroma_table - 2^chroma_width entries to fill
+ * returns:   float - scale from a quantized b, c or d to its value
  * Author: Alijah Jackson
  */
-float* deconstructCodeword(uint64_t codeword) {
-    float* values = malloc(6 * sizeof(float));
-    if (!values) return NULL;
+float dequantizeTables(const Layout *layout, float *a_table,
+                       float *chroma_table) {
+    unsigned a_count = 1u << layout->a_width;
+    unsigned chroma_count = 1u << layout->chroma_width;
 
-    values[0] = ((unsigned) Bitpack_getu(codeword, 9, 23)) / 511.0f;
-    values[1] = ((int) Bitpack_gets(codeword, 5, 18)) * 0.3f / 15.0f;
-    values[2] = ((int) Bitpack_gets(codeword, 5, 13)) * 0.3f / 15.0f;
-    values[3] = ((int) Bitpack_gets(codeword, 5, 8)) * 0.3f / 15.0f;
-    values[4] = Arith40_chroma_of_index((unsigned) Bitpack_getu(codeword, 
-                                                                4, 4));
-    values[5] = Arith40_chroma_of_index((unsigned) Bitpack_getu(codeword, 
-                                                                4, 0));
-    return values;
+    for (unsigned i = 0; a_table != NULL && i < a_count; i++) {
+        a_table[i] = i / (float)(a_count - 1);
+    }
+    for (unsigned i = 0; i < chroma_count; i++) {
+        chroma_table[i] = dequantizeChroma(i, layout->chroma_width);
+    }
+    return BCD_RANGE / (float)((1 << (layout->bcd_width - 1)) - 1);
 }
 
 /*
@@ -199,5 +643,7 @@ float* chromaBlockAverages(float block[][3]) {
     }
     chroma[0] = clamp((total_cb / 4.0f), -0.5f, 0.5f);
     chroma[1] = clamp((total_cr / 4.0f), -0.5f, 0.5f);
+    STATS_SATURATE(STATS_PB, chroma[0] != total_cb / 4.0f);
+    STATS_SATURATE(STATS_PR, chroma[1] != total_cr / 4.0f);
     return chroma;
-}
\ No newline at end of file
+}
@@ -3,22 +3,34 @@
  * CS 40, Project arith
  * 3/6/2025
  * This file contains function declarations for packing and 
- * unpacking pixels,constructing and deconstructing 
- * codewords, and handling chroma block
+ * unpacking pixels and planar images, describing
+ * codeword layouts, and handling chroma block
  * averages.
  */
 
 #ifndef QUAN_H
 #define QUAN_H
 
-uint64_t* packPixels(const float *ycbcr, int width, int height);
-uint64_t constructCodeword(unsigned a_quantized, int b_quantized, 
-                           int c_quantized, int d_quantized, 
-                           unsigned pb_index, unsigned pr_index);
+#include <stdint.h>
 
-float* unpackPixels(uint64_t* codewords, int width, int height);
-float* deconstructCodeword(uint64_t codeword);
+#include <layout.h>
+#include <bitpackv.h>
+
+uint64_t* packPixels(const float *ycbcr, int width, int height,
+                     const Layout *layout);
+
+float* unpackPixels(const uint64_t* codewords, int width, int height,
+                    const Layout *layout);
+uint64_t* packPlanar(const unsigned char *y, const unsigned char *pb,
+                     const unsigned char *pr, int width, int height,
+                     const Layout *layout);
+void unpackPlanar(const uint64_t *codewords, int width, int height,
+                  unsigned char *y, unsigned char *pb, unsigned char *pr,
+                  const Layout *layout);
 float* chromaBlockAverages(float block[][3]);
+void layoutFields(const Layout *layout, Bitpack_field fields[6]);
+float dequantizeTables(const Layout *layout, float *a_table,
+                       float *chroma_table);
 uint64_t to_little_endian(uint64_t word);
 
 #endif
\ No newline at end of file
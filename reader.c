@@ -14,8 +14,9 @@
 #include <reader.h>
 #include <quan.h>
 #include <arith40.h>
+#include <stats.h>
+#include <segment.h>
 
-char COMPRESSED_HEADER[] = "COMP40 Compressed image format 2";
 int PPM_MAX_VAL = 25;
 
 /*
@@ -57,6 +58,7 @@ PPMData read_ppm(FILE *fp, size_t *size, int *maxval, int *width, int *height) {
                 free(data);
                 return NULL;
         }
+        STATS_BYTES_READ(*size);
 
         return trim_ppm(data, width, height);
 }
@@ -79,22 +81,32 @@ void print_ppm(const PPMData data, int width, int height, int maxVal) {
         printf("P6\n");
         printf("%d %d\n%d\n", width, height, maxVal);
         fwrite(data, 1, width * height * 3, stdout);
+        STATS_BYTES_WRITTEN(width * height * 3);
 }
 
 /*
  * name:      read_compressed
- * purpose:   Reads compressed image data from a file.
+ * purpose:   Reads compressed image data from a file. The first line of
+ *            the header selects the codeword layout, or hands the file to
+ *            read_segmented if it is in the segmented format.
  * arguments: FILE *p - file pointer to the compressed file
  *            size_t *size - pointer to store the size of the compressed data
  *            int *width - pointer to store the width of the image
  *            int *height - pointer to store the height of the image
+ *            const Layout **layout - pointer to store the codeword layout
  * returns:   CompressedData - pointer to the compressed image data
  * Author: Alijah Jackson
  */
-CompressedData read_compressed(FILE *p, size_t *size, int *width, int *height) {
-        char header[40];
+CompressedData read_compressed(FILE *p, size_t *size, int *width, int *height,
+                               const Layout **layout) {
+        char header[64];
         assert(fgets(header, sizeof(header), p) != NULL);
-        assert(strcmp(header, "COMP40 Compressed image format 2\n") == 0);
+        header[strcspn(header, "\n")] = '\0';
+        if (strcmp(header, SEGMENTED_HEADER) == 0) {
+                return read_segmented(p, size, width, height, layout);
+        }
+        *layout = Layout_by_header(header);
+        assert(*layout != NULL);
         assert(fscanf(p, "%d %d", width, height) == 2);
 
         int c;
@@ -106,6 +118,7 @@ CompressedData read_compressed(FILE *p, size_t *size, int *width, int *height) {
 
         size_t read_count = fread(compressedData, sizeof(uint64_t), *size, p);
         assert(read_count == *size);
+        STATS_BYTES_READ(read_count * sizeof(uint64_t));
 
         for (size_t i = 0; i < read_count; i++) {
                 compressedData[i] = to_little_endian(compressedData[i]);
@@ -120,15 +133,17 @@ CompressedData read_compressed(FILE *p, size_t *size, int *width, int *height) {
  * arguments: uint64_t *codewords - pointer to the compressed image data
  *            int width - width of the image
  *            int height - height of the image
+ *            const Layout *layout - codeword layout, names the header
  * returns:   void
  * Author: Alijah Jackson
  */
-void printCompressed(uint64_t *codewords, int width, int height) {
+void printCompressed(uint64_t *codewords, int width, int height,
+                     const Layout *layout) {
         if (codewords == NULL) {
                 fprintf(stderr, "No image data to print.\n");
                 return;
         }
-        printf("%s\n%u %u\n", COMPRESSED_HEADER, width, height);
+        printf("%s\n%u %u\n", layout->header, width, height);
         int total_blocks = (width * height) / 4;
         for (int i = 0; i < total_blocks; i++) {
                 uint64_t codeword = codewords[i];
@@ -136,6 +151,7 @@ void printCompressed(uint64_t *codewords, int width, int height) {
                         putchar((codeword >> shift) & 0xFF);
                 }
         }
+        STATS_BYTES_WRITTEN(total_blocks * sizeof(uint64_t));
 }
 
 /*
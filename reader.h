@@ -12,6 +12,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#include <layout.h>
 
 typedef unsigned char *PPMData;
 typedef uint64_t *CompressedData;
@@ -19,8 +22,10 @@ typedef uint64_t *CompressedData;
 PPMData read_ppm(FILE *fp, size_t *size, int *maxval, int *width, int *height);
 void print_ppm(const PPMData data, int width, int height, int maxVal);
 PPMData trim_ppm(PPMData original_data, int *width, int *height);
-CompressedData read_compressed(FILE *p, size_t *size, int *width, int *height);
-void printCompressed(uint64_t *codewords, int width, int height);
+CompressedData read_compressed(FILE *p, size_t *size, int *width, int *height,
+                               const Layout **layout);
+void printCompressed(uint64_t *codewords, int width, int height,
+                     const Layout *layout);
 void debugPPM(PPMData data, int width, int height);
 void free_image(unsigned char *data);
 int PPM_max_value();
@@ -0,0 +1,483 @@
+/* segment.c
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains functions for writing and reading the segmented
+ * compressed format and the CRC32C used to check each segment.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+/*
+ * On x86-64 the SSE4.2 crc32 instruction is compiled in through a
+ * target attribute and picked at run time, so the default flags still
+ * run on older CPUs.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CRC32C_SSE42 1
+#include <nmmintrin.h>
+#endif
+
+#include <segment.h>
+#include <stats.h>
+
+/*
+ * Byte-at-a-time CRC32C table for the reflected polynomial 0x82F63B78.
+ * It is constant so that segments can be checked from several threads
+ * without any setup.
+ */
+static const uint32_t crc_table[256] = {
+        0x00000000u, 0xF26B8303u, 0xE13B70F7u, 0x1350F3F4u,
+        0xC79A971Fu, 0x35F1141Cu, 0x26A1E7E8u, 0xD4CA64EBu,
+        0x8AD958CFu, 0x78B2DBCCu, 0x6BE22838u, 0x9989AB3Bu,
+        0x4D43CFD0u, 0xBF284CD3u, 0xAC78BF27u, 0x5E133C24u,
+        0x105EC76Fu, 0xE235446Cu, 0xF165B798u, 0x030E349Bu,
+        0xD7C45070u, 0x25AFD373u, 0x36FF2087u, 0xC494A384u,
+        0x9A879FA0u, 0x68EC1CA3u, 0x7BBCEF57u, 0x89D76C54u,
+        0x5D1D08BFu, 0xAF768BBCu, 0xBC267848u, 0x4E4DFB4Bu,
+        0x20BD8EDEu, 0xD2D60DDDu, 0xC186FE29u, 0x33ED7D2Au,
+        0xE72719C1u, 0x154C9AC2u, 0x061C6936u, 0xF477EA35u,
+        0xAA64D611u, 0x580F5512u, 0x4B5FA6E6u, 0xB93425E5u,
+        0x6DFE410Eu, 0x9F95C20Du, 0x8CC531F9u, 0x7EAEB2FAu,
+        0x30E349B1u, 0xC288CAB2u, 0xD1D83946u, 0x23B3BA45u,
+        0xF779DEAEu, 0x05125DADu, 0x1642AE59u, 0xE4292D5Au,
+        0xBA3A117Eu, 0x4851927Du, 0x5B016189u, 0xA96AE28Au,
+        0x7DA08661u, 0x8FCB0562u, 0x9C9BF696u, 0x6EF07595u,
+        0x417B1DBCu, 0xB3109EBFu, 0xA0406D4Bu, 0x522BEE48u,
+        0x86E18AA3u, 0x748A09A0u, 0x67DAFA54u, 0x95B17957u,
+        0xCBA24573u, 0x39C9C670u, 0x2A993584u, 0xD8F2B687u,
+        0x0C38D26Cu, 0xFE53516Fu, 0xED03A29Bu, 0x1F682198u,
+        0x5125DAD3u, 0xA34E59D0u, 0xB01EAA24u, 0x42752927u,
+        0x96BF4DCCu, 0x64D4CECFu, 0x77843D3Bu, 0x85EFBE38u,
+        0xDBFC821Cu, 0x2997011Fu, 0x3AC7F2EBu, 0xC8AC71E8u,
+        0x1C661503u, 0xEE0D9600u, 0xFD5D65F4u, 0x0F36E6F7u,
+        0x61C69362u, 0x93AD1061u, 0x80FDE395u, 0x72966096u,
+        0xA65C047Du, 0x5437877Eu, 0x4767748Au, 0xB50CF789u,
+        0xEB1FCBADu, 0x197448AEu, 0x0A24BB5Au, 0xF84F3859u,
+        0x2C855CB2u, 0xDEEEDFB1u, 0xCDBE2C45u, 0x3FD5AF46u,
+        0x7198540Du, 0x83F3D70Eu, 0x90A324FAu, 0x62C8A7F9u,
+        0xB602C312u, 0x44694011u, 0x5739B3E5u, 0xA55230E6u,
+        0xFB410CC2u, 0x092A8FC1u, 0x1A7A7C35u, 0xE811FF36u,
+        0x3CDB9BDDu, 0xCEB018DEu, 0xDDE0EB2Au, 0x2F8B6829u,
+        0x82F63B78u, 0x709DB87Bu, 0x63CD4B8Fu, 0x91A6C88Cu,
+        0x456CAC67u, 0xB7072F64u, 0xA457DC90u, 0x563C5F93u,
+        0x082F63B7u, 0xFA44E0B4u, 0xE9141340u, 0x1B7F9043u,
+        0xCFB5F4A8u, 0x3DDE77ABu, 0x2E8E845Fu, 0xDCE5075Cu,
+        0x92A8FC17u, 0x60C37F14u, 0x73938CE0u, 0x81F80FE3u,
+        0x55326B08u, 0xA759E80Bu, 0xB4091BFFu, 0x466298FCu,
+        0x1871A4D8u, 0xEA1A27DBu, 0xF94AD42Fu, 0x0B21572Cu,
+        0xDFEB33C7u, 0x2D80B0C4u, 0x3ED04330u, 0xCCBBC033u,
+        0xA24BB5A6u, 0x502036A5u, 0x4370C551u, 0xB11B4652u,
+        0x65D122B9u, 0x97BAA1BAu, 0x84EA524Eu, 0x7681D14Du,
+        0x2892ED69u, 0xDAF96E6Au, 0xC9A99D9Eu, 0x3BC21E9Du,
+        0xEF087A76u, 0x1D63F975u, 0x0E330A81u, 0xFC588982u,
+        0xB21572C9u, 0x407EF1CAu, 0x532E023Eu, 0xA145813Du,
+        0x758FE5D6u, 0x87E466D5u, 0x94B49521u, 0x66DF1622u,
+        0x38CC2A06u, 0xCAA7A905u, 0xD9F75AF1u, 0x2B9CD9F2u,
+        0xFF56BD19u, 0x0D3D3E1Au, 0x1E6DCDEEu, 0xEC064EEDu,
+        0xC38D26C4u, 0x31E6A5C7u, 0x22B65633u, 0xD0DDD530u,
+        0x0417B1DBu, 0xF67C32D8u, 0xE52CC12Cu, 0x1747422Fu,
+        0x49547E0Bu, 0xBB3FFD08u, 0xA86F0EFCu, 0x5A048DFFu,
+        0x8ECEE914u, 0x7CA56A17u, 0x6FF599E3u, 0x9D9E1AE0u,
+        0xD3D3E1ABu, 0x21B862A8u, 0x32E8915Cu, 0xC083125Fu,
+        0x144976B4u, 0xE622F5B7u, 0xF5720643u, 0x07198540u,
+        0x590AB964u, 0xAB613A67u, 0xB831C993u, 0x4A5A4A90u,
+        0x9E902E7Bu, 0x6CFBAD78u, 0x7FAB5E8Cu, 0x8DC0DD8Fu,
+        0xE330A81Au, 0x115B2B19u, 0x020BD8EDu, 0xF0605BEEu,
+        0x24AA3F05u, 0xD6C1BC06u, 0xC5914FF2u, 0x37FACCF1u,
+        0x69E9F0D5u, 0x9B8273D6u, 0x88D28022u, 0x7AB90321u,
+        0xAE7367CAu, 0x5C18E4C9u, 0x4F48173Du, 0xBD23943Eu,
+        0xF36E6F75u, 0x0105EC76u, 0x12551F82u, 0xE03E9C81u,
+        0x34F4F86Au, 0xC69F7B69u, 0xD5CF889Du, 0x27A40B9Eu,
+        0x79B737BAu, 0x8BDCB4B9u, 0x988C474Du, 0x6AE7C44Eu,
+        0xBE2DA0A5u, 0x4C4623A6u, 0x5F16D052u, 0xAD7D5351u
+};
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static void put_be32(unsigned char *bytes, uint32_t value);
+static uint32_t get_be32(const unsigned char *bytes);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      printSegmented
+ * purpose:   Prints compressed image data to stdout in the segmented
+ *            format, splitting the codewords into runs of segment_rows
+ *            block rows that can each be checked and decoded on their own.
+ * arguments: uint64_t *codewords - pointer to the compressed image data
+ *            int width - width of the image
+ *            int height - height of the image
+ *            const Layout *layout - codeword layout of the data
+ *            int segment_rows - block rows per segment
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void printSegmented(uint64_t *codewords, int width, int height,
+                    const Layout *layout, int segment_rows) {
+        if (codewords == NULL) {
+                fprintf(stderr, "No image data to print.\n");
+                return;
+        }
+        assert(segment_rows > 0);
+
+        int block_width = width / 2;
+        int block_rows = height / 2;
+        int count = (block_rows + segment_rows - 1) / segment_rows;
+        size_t row_bytes = (size_t)block_width * sizeof(uint64_t);
+        size_t total = row_bytes * block_rows;
+
+        char info[SEGMENT_INFO_SIZE];
+        unsigned char info_crc[4];
+        snprintf(info, sizeof(info), "%s %d %d %d\n", layout->name, width,
+                 height, count);
+        put_be32(info_crc, crc32c(0, (const unsigned char *)info,
+                                  strlen(info)));
+
+        unsigned char *payload = malloc(total + 1);
+        unsigned char *table = malloc(count * SEGMENT_ENTRY_SIZE + 4);
+        assert(payload != NULL && table != NULL);
+
+        for (size_t i = 0; i < total / sizeof(uint64_t); i++) {
+                for (int byte = 0; byte < 8; byte++) {
+                        payload[i * 8 + byte] =
+                                (codewords[i] >> (56 - 8 * byte)) & 0xFF;
+                }
+        }
+
+        Segment *segments = malloc(count * sizeof(Segment) + 1);
+        assert(segments != NULL);
+        for (int s = 0; s < count; s++) {
+                int first_row = s * segment_rows;
+                int rows = block_rows - first_row;
+                rows = (rows > segment_rows) ? segment_rows : rows;
+
+                segments[s].first_row = first_row;
+                segments[s].rows = rows;
+                segments[s].length = rows * row_bytes;
+                segments[s].crc = crc32c(0, payload + first_row * row_bytes,
+                                         segments[s].length);
+        }
+        Segment_write_table(info, segments, count, table);
+        free(segments);
+
+        printf("%s\n%s", SEGMENTED_HEADER, info);
+        fwrite(info_crc, 1, 4, stdout);
+        fwrite(table, 1, count * SEGMENT_ENTRY_SIZE + 4, stdout);
+        fwrite(payload, 1, total, stdout);
+        STATS_BYTES_WRITTEN(strlen(info) + 4 + count * SEGMENT_ENTRY_SIZE +
+                            4 + total);
+
+        free(table);
+        free(payload);
+}
+
+/*
+ * name:      read_segmented
+ * purpose:   Reads a segmented compressed image, after its first header
+ *            line has been consumed. The header line and the segment
+ *            table are checked first, and a failure in either is reported
+ *            as such. Every segment is then checked against its CRC32C;
+ *            each one that fails is reported by number and block rows,
+ *            and the program exits if any did.
+ * arguments: FILE *fp - file pointer to the compressed file
+ *            size_t *size - pointer to store the number of codewords
+ *            int *width - pointer to store the width of the image
+ *            int *height - pointer to store the height of the image
+ *            const Layout **layout - pointer to store the codeword layout
+ * returns:   uint64_t* - the codewords of the whole image
+ * Author: Alijah Jackson
+ */
+uint64_t *read_segmented(FILE *fp, size_t *size, int *width, int *height,
+                         const Layout **layout) {
+        char info[SEGMENT_INFO_SIZE];
+        int count;
+        if (!Segment_read_info(fp, info, layout, width, height, &count)) {
+                fprintf(stderr, "Segment header (layout, size and segment "
+                        "count) failed its checksum\n");
+                exit(EXIT_FAILURE);
+        }
+
+        Segment *segments = malloc(count * sizeof(Segment) + 1);
+        assert(segments != NULL);
+        if (!Segment_read_table(fp, info, segments, count)) {
+                fprintf(stderr, "Segment table failed its checksum\n");
+                exit(EXIT_FAILURE);
+        }
+
+        if (!Segment_covers(segments, count, *width, *height)) {
+                fprintf(stderr, "Segment table does not cover the "
+                        "image\n");
+                exit(EXIT_FAILURE);
+        }
+
+        int block_width = *width / 2;
+        uint32_t block_rows = *height / 2;
+        size_t row_bytes = (size_t)block_width * sizeof(uint64_t);
+
+        *size = (size_t)block_width * block_rows;
+        size_t total = *size * sizeof(uint64_t);
+        unsigned char *payload = calloc(total + 1, 1);
+        uint64_t *codewords = malloc(*size * sizeof(uint64_t) + 1);
+        assert(payload != NULL && codewords != NULL);
+
+        size_t read_count = fread(payload, 1, total, fp);
+        if (read_count != total) {
+                fprintf(stderr, "Compressed data is truncated after "
+                        "%zu of %zu payload bytes\n", read_count, total);
+        }
+        STATS_BYTES_READ(strlen(info) + 4 + count * SEGMENT_ENTRY_SIZE + 4 +
+                         read_count);
+
+        int failures = 0;
+        for (int s = 0; s < count; s++) {
+                size_t offset = segments[s].first_row * row_bytes;
+                if (!Segment_decode(&segments[s], payload + offset, *width,
+                                    codewords)) {
+                        fprintf(stderr, "Segment %d (block rows %u-%u) "
+                                "failed its checksum\n", s,
+                                segments[s].first_row,
+                                segments[s].first_row + segments[s].rows - 1);
+                        failures++;
+                }
+        }
+
+        free(payload);
+        free(segments);
+        if (failures > 0) {
+                exit(EXIT_FAILURE);
+        }
+        return codewords;
+}
+
+/*
+ * name:      Segment_decode
+ * purpose:   Checks one segment's payload against its CRC32C and, if it
+ *            matches, decodes its codewords into place. Segments share no
+ *            state, so separate threads or processes reading separate byte
+ *            ranges can each decode their own.
+ * arguments: const Segment *segment - the segment's table entry
+ *            const unsigned char *payload - the segment's payload bytes
+ *            int width - width of the image
+ *            uint64_t *codewords - codewords of the whole image
+ * returns:   bool - true if the checksum matched, false otherwise
+ * Author: Alijah Jackson
+ */
+bool Segment_decode(const Segment *segment, const unsigned char *payload,
+                    int width, uint64_t *codewords) {
+        if (crc32c(0, payload, segment->length) != segment->crc) {
+                return false;
+        }
+        uint64_t *out = codewords + (size_t)segment->first_row * (width / 2);
+        size_t n = segment->length / sizeof(uint64_t);
+        for (size_t i = 0; i < n; i++) {
+                uint64_t word = 0;
+                for (int byte = 0; byte < 8; byte++) {
+                        word = (word << 8) | payload[i * 8 + byte];
+                }
+                out[i] = word;
+        }
+        return true;
+}
+
+/*
+ * name:      Segment_read_info
+ * purpose:   Reads the line after the segmented header (layout name,
+ *            size and segment count) and the checksum that follows it
+ * arguments: FILE *fp - file pointer positioned after the first line
+ *            char *info - SEGMENT_INFO_SIZE bytes to store the line in,
+ *                         newline included, for Segment_read_table
+ *            const Layout **layout - pointer to store the layout
+ *            int *width, int *height - pointers to store the size
+ *            int *count - pointer to store the number of segments
+ * returns:   bool - true if the line's checksum matched and its values
+ *                   are usable, false otherwise
+ * Author: Alijah Jackson
+ */
+bool Segment_read_info(FILE *fp, char *info, const Layout **layout,
+                       int *width, int *height, int *count) {
+        unsigned char crc[4];
+        char name[SEGMENT_INFO_SIZE];
+
+        if (fgets(info, SEGMENT_INFO_SIZE, fp) == NULL ||
+            strchr(info, '\n') == NULL || fread(crc, 1, 4, fp) != 4 ||
+            crc32c(0, (const unsigned char *)info, strlen(info)) !=
+            get_be32(crc)) {
+                return false;
+        }
+        if (sscanf(info, "%63s %d %d %d", name, width, height, count) != 4) {
+                return false;
+        }
+        *layout = Layout_by_name(name);
+        return *layout != NULL && *width >= 0 && *height >= 0 &&
+               *count >= 0 && *count <= *height / 2;
+}
+
+/*
+ * name:      Segment_read_table
+ * purpose:   Reads a segment table and the checksum that follows it,
+ *            which also covers the header line before the table
+ * arguments: FILE *fp - file pointer positioned at the table
+ *            const char *info - header line from Segment_read_info
+ *            Segment *segments - where to store the count entries
+ *            int count - number of segments
+ * returns:   bool - true if the table was read whole and its checksum
+ *                   matched, false otherwise
+ * Author: Alijah Jackson
+ */
+bool Segment_read_table(FILE *fp, const char *info, Segment *segments,
+                        int count) {
+        size_t table_size = count * SEGMENT_ENTRY_SIZE;
+        unsigned char *table = malloc(table_size + 4);
+        assert(table != NULL);
+
+        uint32_t crc = crc32c(0, (const unsigned char *)info, strlen(info));
+        bool ok = fread(table, 1, table_size + 4, fp) == table_size + 4 &&
+                  crc32c(crc, table, table_size) ==
+                  get_be32(table + table_size);
+        for (int s = 0; ok && s < count; s++) {
+                unsigned char *entry = table + s * SEGMENT_ENTRY_SIZE;
+                segments[s].first_row = get_be32(entry);
+                segments[s].rows = get_be32(entry + 4);
+                segments[s].length = get_be32(entry + 8);
+                segments[s].crc = get_be32(entry + 12);
+        }
+        free(table);
+        return ok;
+}
+
+/*
+ * name:      Segment_covers
+ * purpose:   Checks that a segment table tiles the image: segments are
+ *            in order, each holds at least one block row and exactly
+ *            that many rows of codewords, and together they cover every
+ *            block row once. Readers must check this before using the
+ *            table to place payloads or map rows to segments.
+ * arguments: const Segment *segments - the count entries
+ *            int count - number of segments
+ *            int width, int height - dimensions of the image
+ * returns:   bool - true if the table covers the image exactly
+ * Author: Alijah Jackson
+ */
+bool Segment_covers(const Segment *segments, int count, int width,
+                    int height) {
+        size_t row_bytes = (size_t)(width / 2) * sizeof(uint64_t);
+        uint32_t next_row = 0;
+        for (int s = 0; s < count; s++) {
+                if (segments[s].first_row != next_row ||
+                    segments[s].rows == 0 ||
+                    segments[s].length != segments[s].rows * row_bytes) {
+                        return false;
+                }
+                next_row += segments[s].rows;
+        }
+        return next_row == (uint32_t)(height / 2);
+}
+
+/*
+ * name:      Segment_write_table
+ * purpose:   Serializes a segment table followed by its checksum, which
+ *            covers the header line and the table
+ * arguments: const char *info - header line, newline included
+ *            const Segment *segments - the count entries
+ *            int count - number of segments
+ *            unsigned char *table - buffer of count * SEGMENT_ENTRY_SIZE
+ *                                   + 4 bytes to fill
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Segment_write_table(const char *info, const Segment *segments,
+                         int count, unsigned char *table) {
+        for (int s = 0; s < count; s++) {
+                unsigned char *entry = table + s * SEGMENT_ENTRY_SIZE;
+                put_be32(entry, segments[s].first_row);
+                put_be32(entry + 4, segments[s].rows);
+                put_be32(entry + 8, segments[s].length);
+                put_be32(entry + 12, segments[s].crc);
+        }
+        uint32_t crc = crc32c(0, (const unsigned char *)info, strlen(info));
+        put_be32(table + count * SEGMENT_ENTRY_SIZE,
+                 crc32c(crc, table, count * SEGMENT_ENTRY_SIZE));
+}
+
+#ifdef CRC32C_SSE42
+/*
+ * name:      crc32c_sse42
+ * purpose:   Runs the CRC32C register over a buffer with the SSE4.2
+ *            crc32 instruction, eight bytes at a time
+ * arguments: uint32_t crc - the inverted running CRC
+ *            const unsigned char *data - bytes to checksum
+ *            size_t length - number of bytes
+ * returns:   uint32_t - the inverted running CRC
+ * Author: Alijah Jackson
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *data,
+                             size_t length) {
+        uint64_t crc64 = crc;
+        for (; length >= 8; data += 8, length -= 8) {
+                uint64_t chunk;
+                memcpy(&chunk, data, 8);
+                crc64 = _mm_crc32_u64(crc64, chunk);
+        }
+        crc = (uint32_t)crc64;
+        for (; length > 0; data++, length--) {
+                crc = _mm_crc32_u8(crc, *data);
+        }
+        return crc;
+}
+#endif
+
+/*
+ * name:      crc32c
+ * purpose:   Computes the CRC32C (Castagnoli) of a buffer, using the
+ *            SSE4.2 crc32 instruction when the CPU has it
+ * arguments: uint32_t crc - CRC of the preceding data, or 0 to start
+ *            const unsigned char *data - bytes to checksum
+ *            size_t length - number of bytes
+ * returns:   uint32_t - the updated CRC
+ * Author: Alijah Jackson
+ */
+uint32_t crc32c(uint32_t crc, const unsigned char *data, size_t length) {
+        crc = ~crc;
+#ifdef CRC32C_SSE42
+        if (__builtin_cpu_supports("sse4.2")) {
+                return ~crc32c_sse42(crc, data, length);
+        }
+#endif
+        for (size_t i = 0; i < length; i++) {
+                crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+}
+
+/*
+************************  HELPER FUNCTIONS ****************************
+*/
+
+/*
+ * name:      put_be32 / get_be32
+ * purpose:   Store and load a 32-bit value in big-endian byte order
+ * arguments: bytes - the four bytes; value - the value to store
+ * returns:   void / uint32_t - the loaded value
+ * Author: Alijah Jackson
+ */
+static void put_be32(unsigned char *bytes, uint32_t value) {
+        bytes[0] = value >> 24;
+        bytes[1] = (value >> 16) & 0xFF;
+        bytes[2] = (value >> 8) & 0xFF;
+        bytes[3] = value & 0xFF;
+}
+
+static uint32_t get_be32(const unsigned char *bytes) {
+        return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+               ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
@@ -0,0 +1,57 @@
+/* segment.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains declarations for the segmented compressed format,
+ * which splits the codewords into independent runs of block rows, each
+ * with its own length and CRC32C, listed in a table before the payloads.
+ *
+ * Layout of a segmented file:
+ *   COMP40 Segmented image format 2\n
+ *   <layout name> <width> <height> <segment count>\n
+ *   CRC32C of the line above (big-endian uint32)
+ *   segment table: count entries of first_row, rows, length, crc
+ *                  (four big-endian uint32s each)
+ *   CRC32C of the line above the table and the table (big-endian uint32)
+ *   payloads, in table order, each a run of big-endian codewords
+ */
+
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <layout.h>
+
+#define SEGMENTED_HEADER "COMP40 Segmented image format 2"
+#define SEGMENT_INFO_SIZE 64
+#define SEGMENT_ENTRY_SIZE 16
+#define DEFAULT_SEGMENT_ROWS 16
+
+typedef struct Segment {
+        uint32_t first_row;     /* first block row in the segment */
+        uint32_t rows;          /* number of block rows */
+        uint32_t length;        /* payload length in bytes */
+        uint32_t crc;           /* CRC32C of the payload */
+} Segment;
+
+uint32_t crc32c(uint32_t crc, const unsigned char *data, size_t length);
+void printSegmented(uint64_t *codewords, int width, int height,
+                    const Layout *layout, int segment_rows);
+uint64_t *read_segmented(FILE *fp, size_t *size, int *width, int *height,
+                         const Layout **layout);
+bool Segment_read_info(FILE *fp, char *info, const Layout **layout,
+                       int *width, int *height, int *count);
+bool Segment_read_table(FILE *fp, const char *info, Segment *segments,
+                        int count);
+bool Segment_covers(const Segment *segments, int count, int width,
+                    int height);
+void Segment_write_table(const char *info, const Segment *segments,
+                         int count, unsigned char *table);
+bool Segment_decode(const Segment *segment, const unsigned char *payload,
+                    int width, uint64_t *codewords);
+
+#endif
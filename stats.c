@@ -0,0 +1,278 @@
+/* stats.c
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the collection and reporting side of the --stats
+ * instrumentation: stage and stripe timers, the JSON summary and the
+ * Chrome trace-event output. It is only built with make STATS=1.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <stats.h>
+
+#define MAX_EVENTS 4096
+
+Stats_counters stats_counters;
+
+static const char *STAGE_NAMES[STATS_NUM_STAGES] = {
+        "read", "color", "quantize", "write"
+};
+static const char *FIELD_NAMES[STATS_NUM_FIELDS] = {
+        "a", "b", "c", "d", "pb", "pr"
+};
+
+typedef struct Stats_event {
+        Stats_stage stage;
+        int first_row, rows;    /* block rows of a stripe; rows is 0 for a
+                                   whole stage */
+        uint64_t start_ns;
+        uint64_t duration_ns;
+} Stats_event;
+
+static uint64_t stage_ns[STATS_NUM_STAGES];
+static uint64_t stage_cycles[STATS_NUM_STAGES];
+static uint64_t start_ns[STATS_NUM_STAGES];
+static uint64_t start_cycles[STATS_NUM_STAGES];
+static uint64_t origin_ns;
+
+static int stripe_row = -1;    /* first row of the open stripe, or -1 */
+static uint64_t stripe_start_ns;
+
+static Stats_event events[MAX_EVENTS];
+static int num_events = 0;
+static int dropped_events = 0;
+
+/*
+******************************  PROTOTYPE FUNCTIONS ************************
+*/
+
+static uint64_t now_ns(void);
+static uint64_t now_cycles(void);
+static void record_event(Stats_stage stage, int first_row, int rows,
+                         uint64_t start, uint64_t duration);
+static void write_trace(const char *trace_path);
+
+/*
+******************************  MAIN FUNCTIONS ************************
+*/
+
+/*
+ * name:      Stats_stage_begin
+ * purpose:   Starts the timer for one stage of the codec.
+ * arguments: Stats_stage stage - the stage being entered
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Stats_stage_begin(Stats_stage stage) {
+        if (origin_ns == 0) {
+                origin_ns = now_ns();
+        }
+        start_ns[stage] = now_ns();
+        start_cycles[stage] = now_cycles();
+}
+
+/*
+ * name:      Stats_stage_end
+ * purpose:   Stops the timer for one stage, adds the elapsed time and
+ *            cycles to that stage's totals and records a trace event.
+ * arguments: Stats_stage stage - the stage being left
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Stats_stage_end(Stats_stage stage) {
+        uint64_t elapsed = now_ns() - start_ns[stage];
+
+        stage_ns[stage] += elapsed;
+        stage_cycles[stage] += now_cycles() - start_cycles[stage];
+        record_event(stage, 0, 0, start_ns[stage], elapsed);
+}
+
+/*
+ * name:      Stats_stripe
+ * purpose:   Ends the open stripe, if any, and starts timing the next
+ *            one. Used through STATS_STRIPE inside per-block loops.
+ * arguments: Stats_stage stage - the stage the stripe belongs to
+ *            int first_row - first block row of the new stripe
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Stats_stripe(Stats_stage stage, int first_row) {
+        uint64_t now = now_ns();
+        if (stripe_row >= 0) {
+                record_event(stage, stripe_row, first_row - stripe_row,
+                             stripe_start_ns, now - stripe_start_ns);
+        }
+        stripe_row = first_row;
+        stripe_start_ns = now;
+}
+
+/*
+ * name:      Stats_stripe_done
+ * purpose:   Ends the last stripe of a per-block loop
+ * arguments: Stats_stage stage - the stage the stripe belongs to
+ *            int block_rows - block rows in the whole image
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Stats_stripe_done(Stats_stage stage, int block_rows) {
+        if (stripe_row >= 0) {
+                record_event(stage, stripe_row, block_rows - stripe_row,
+                             stripe_start_ns, now_ns() - stripe_start_ns);
+        }
+        stripe_row = -1;
+}
+
+/*
+ * name:      Stats_report
+ * purpose:   Prints the collected counters as a JSON object and, if a
+ *            path is given, writes the recorded stages and stripes as a
+ *            Chrome trace-event file.
+ * arguments: FILE *json - stream to print the JSON summary to
+ *            const char *trace_path - trace file path, or NULL for none
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+void Stats_report(FILE *json, const char *trace_path) {
+        fprintf(json, "{\n  \"bytes_read\": %llu,\n"
+                "  \"bytes_written\": %llu,\n  \"stages\": {",
+                (unsigned long long)stats_counters.bytes_read,
+                (unsigned long long)stats_counters.bytes_written);
+        for (int s = 0; s < STATS_NUM_STAGES; s++) {
+                fprintf(json, "%s\n    \"%s\": { \"ns\": %llu, "
+                        "\"cycles\": %llu }", s == 0 ? "" : ",",
+                        STAGE_NAMES[s], (unsigned long long)stage_ns[s],
+                        (unsigned long long)stage_cycles[s]);
+        }
+
+        fprintf(json, "\n  },\n  \"saturated\": {");
+        for (int f = 0; f < STATS_NUM_FIELDS; f++) {
+                fprintf(json, "%s \"%s\": %llu", f == 0 ? "" : ",",
+                        FIELD_NAMES[f],
+                        (unsigned long long)stats_counters.saturated[f]);
+        }
+
+        fprintf(json, " },\n  \"histograms\": {");
+        for (int f = 0; f < STATS_NUM_FIELDS; f++) {
+                fprintf(json, "%s\n    \"%s\": {", f == 0 ? "" : ",",
+                        FIELD_NAMES[f]);
+                int first = 1;
+                for (int bin = 0; bin < STATS_HIST_BINS; bin++) {
+                        uint64_t count = stats_counters.histogram[f][bin];
+                        if (count == 0) continue;
+                        fprintf(json, "%s \"%d\": %llu", first ? "" : ",",
+                                bin - STATS_HIST_BINS / 2,
+                                (unsigned long long)count);
+                        first = 0;
+                }
+                fprintf(json, " }");
+        }
+        fprintf(json, "\n  }\n}\n");
+
+        if (trace_path != NULL) {
+                write_trace(trace_path);
+        }
+}
+
+/*
+******************************  HELPER FUNCTIONS **************************
+*/
+
+/*
+ * name:      now_ns
+ * purpose:   Reads the monotonic clock
+ * arguments: void
+ * returns:   uint64_t - current time in nanoseconds
+ * Author: Alijah Jackson
+ */
+static uint64_t now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * name:      now_cycles
+ * purpose:   Reads the CPU timestamp counter where one is available
+ * arguments: void
+ * returns:   uint64_t - current cycle count, or 0 on other targets
+ * Author: Alijah Jackson
+ */
+static uint64_t now_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+}
+
+/*
+ * name:      record_event
+ * purpose:   Stores one trace event, dropping it once the buffer is full
+ * arguments: Stats_stage stage - the stage the event belongs to
+ *            int first_row, int rows - a stripe's block rows, or 0, 0
+ *            uint64_t start - start time in nanoseconds
+ *            uint64_t duration - duration in nanoseconds
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void record_event(Stats_stage stage, int first_row, int rows,
+                         uint64_t start, uint64_t duration) {
+        if (num_events == MAX_EVENTS) {
+                dropped_events++;
+                return;
+        }
+        events[num_events].stage = stage;
+        events[num_events].first_row = first_row;
+        events[num_events].rows = rows;
+        events[num_events].start_ns = start - origin_ns;
+        events[num_events].duration_ns = duration;
+        num_events++;
+}
+
+/*
+ * name:      write_trace
+ * purpose:   Writes the recorded events in Chrome trace-event format
+ *            (load with chrome://tracing or Perfetto). Stripes are
+ *            nested inside the stage they ran in.
+ * arguments: const char *trace_path - path of the file to write
+ * returns:   void
+ * Author: Alijah Jackson
+ */
+static void write_trace(const char *trace_path) {
+        FILE *fp = fopen(trace_path, "w");
+        if (fp == NULL) {
+                fprintf(stderr, "Could not open trace file %s\n", trace_path);
+                return;
+        }
+        fprintf(fp, "{\"traceEvents\":[");
+        for (int i = 0; i < num_events; i++) {
+                const Stats_event *event = &events[i];
+                fprintf(fp, "%s\n{\"name\":\"%s%s\",\"ph\":\"X\",\"pid\":1,"
+                        "\"tid\":1,\"ts\":%.3f,\"dur\":%.3f",
+                        i == 0 ? "" : ",", STAGE_NAMES[event->stage],
+                        event->rows > 0 ? " stripe" : "",
+                        event->start_ns / 1000.0,
+                        event->duration_ns / 1000.0);
+                if (event->rows > 0) {
+                        fprintf(fp, ",\"args\":{\"first_row\":%d,"
+                                "\"rows\":%d}", event->first_row,
+                                event->rows);
+                }
+                fprintf(fp, "}");
+        }
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+        if (dropped_events > 0) {
+                fprintf(stderr, "Trace buffer full, %d events dropped\n",
+                        dropped_events);
+        }
+}
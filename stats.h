@@ -0,0 +1,95 @@
+/* stats.h
+ * Alijah Jackson
+ * CS 40, Project arith
+ * 10/19/2026
+ * This file contains the opt-in instrumentation hooks used by the codec:
+ * saturation counters, quantized field histograms, per-stage and
+ * per-stripe timings and byte counts. Everything here compiles to
+ * nothing unless STATS40 is defined (make STATS=1).
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef enum {
+        STATS_READ, STATS_COLOR, STATS_QUANTIZE, STATS_WRITE,
+        STATS_NUM_STAGES
+} Stats_stage;
+
+typedef enum {
+        STATS_A, STATS_B, STATS_C, STATS_D, STATS_PB, STATS_PR,
+        STATS_NUM_FIELDS
+} Stats_field;
+
+/* Histogram bins cover quantized values in [-2048, 2047] */
+#define STATS_HIST_BINS 4096
+
+/* Block rows per traced stripe, the same as DEFAULT_SEGMENT_ROWS */
+#define STATS_STRIPE_ROWS 16
+
+#ifdef STATS40
+
+#define STATS_ENABLED 1
+
+/*
+ * Plain, non-atomic counters. The codec runs on a single thread, so this
+ * one instance is that thread's private copy and the hot path never
+ * touches shared state.
+ */
+typedef struct Stats_counters {
+        uint64_t saturated[STATS_NUM_FIELDS];
+        uint64_t histogram[STATS_NUM_FIELDS][STATS_HIST_BINS];
+        uint64_t bytes_read;
+        uint64_t bytes_written;
+} Stats_counters;
+
+extern Stats_counters stats_counters;
+
+void Stats_stage_begin(Stats_stage stage);
+void Stats_stage_end(Stats_stage stage);
+void Stats_stripe(Stats_stage stage, int first_row);
+void Stats_stripe_done(Stats_stage stage, int block_rows);
+void Stats_report(FILE *json, const char *trace_path);
+
+#define STATS_BEGIN(stage) Stats_stage_begin(stage)
+#define STATS_END(stage) Stats_stage_end(stage)
+/*
+ * Called at the top of a per-block loop, in block order: every
+ * STATS_STRIPE_ROWS block rows this ends the previous stripe's trace
+ * event and starts the next. STATS_STRIPE_DONE ends the last one.
+ */
+#define STATS_STRIPE(stage, block_idx, block_width) \
+        (((block_idx) % ((block_width) * STATS_STRIPE_ROWS) == 0) \
+                ? Stats_stripe((stage), (block_idx) / (block_width)) \
+                : (void)0)
+#define STATS_STRIPE_DONE(stage, block_rows) \
+        Stats_stripe_done((stage), (block_rows))
+#define STATS_SATURATE(field, hit) \
+        (stats_counters.saturated[(field)] += ((hit) != 0))
+#define STATS_HISTOGRAM(field, value) \
+        (stats_counters.histogram[(field)] \
+                [((value) + STATS_HIST_BINS / 2) & (STATS_HIST_BINS - 1)]++)
+#define STATS_BYTES_READ(n) (stats_counters.bytes_read += (n))
+#define STATS_BYTES_WRITTEN(n) (stats_counters.bytes_written += (n))
+#define STATS_REPORT(json, trace_path) Stats_report((json), (trace_path))
+
+#else
+
+#define STATS_ENABLED 0
+
+#define STATS_BEGIN(stage) ((void)0)
+#define STATS_END(stage) ((void)0)
+#define STATS_STRIPE(stage, block_idx, block_width) ((void)0)
+#define STATS_STRIPE_DONE(stage, block_rows) ((void)0)
+#define STATS_SATURATE(field, hit) ((void)0)
+#define STATS_HISTOGRAM(field, value) ((void)0)
+#define STATS_BYTES_READ(n) ((void)0)
+#define STATS_BYTES_WRITTEN(n) ((void)0)
+#define STATS_REPORT(json, trace_path) ((void)0)
+
+#endif
+
+#endif